@@ -0,0 +1,79 @@
+#include <chrono>
+
+#include "parser.h"
+#include "kernel.h"
+#include "debug.h"
+#include "operator.h"
+
+/**
+ * @brief Microbenchmark comparing the vectorized pickup position kernel against its scalar version.
+ * Every shipped instance is first improved for a short while, such that routes are realistically filled,
+ * and then every admissible pickup position of every (vehicle, call) pair is evaluated many times by both.
+ */
+int main(int argc, char const *argv[])
+{
+    std::vector<std::string> instances = {"Call_7_Vehicle_3", "Call_18_Vehicle_5", "Call_35_Vehicle_7", "Call_80_Vehicle_20", "Call_130_Vehicle_40", "Call_300_Vehicle_90"};
+    int repetitions = 200;
+
+    Xoshiro256 rng{42};
+    Operator* neighbourOperator = new RandomGreedyInsert();
+
+    for (std::string& instance : instances) {
+        Problem problem = Parser::parseProblem("data/" + instance + ".txt");
+
+        // Fill routes by running a short local search from the initial solution
+        Solution solution = Solution::initialSolution(&problem);
+        for (int i = 0; i < 100; i++) {
+            Solution neighbour = neighbourOperator->apply(&solution, i, rng);
+            if (neighbour.isFeasible() && neighbour.getCost() < solution.getCost()) {
+                solution = neighbour;
+            }
+        }
+
+        // Gather a batch for every pair of vehicle and compatible call, over every pickup position
+        std::vector<PickupBatch> batches;
+        long long positions = 0;
+        for (int vehicleIndex = 1; vehicleIndex <= problem.noVehicles; vehicleIndex++) {
+            for (int callIndex : problem.vehicles[vehicleIndex-1].possibleCalls) {
+                if (!solution.callDetails[callIndex-1].removed && solution.callDetails[callIndex-1].vehicle == vehicleIndex) {
+                    continue;
+                }
+                PickupBatch batch;
+                gatherPickupPositions(vehicleIndex, callIndex, solution.representation[vehicleIndex-1].size()+1, &solution, batch);
+                positions += batch.count;
+                batches.push_back(batch);
+            }
+        }
+
+        // Time both versions
+        auto timeKernel = [&](bool vectorized) {
+            std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+            for (int r = 0; r < repetitions; r++) {
+                for (PickupBatch& batch : batches) {
+                    if (vectorized) {
+                        evaluatePickupPositions(batch);
+                    } else {
+                        evaluatePickupPositionsScalar(batch, 0, batch.count);
+                    }
+                }
+            }
+            std::chrono::steady_clock::time_point ended = std::chrono::steady_clock::now();
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(ended - started).count() / (double)(positions * repetitions);
+        };
+
+        double scalar = timeKernel(false);
+        std::vector<PickupBatch> expected = batches;
+        double vectorized = timeKernel(true);
+
+        // Verify both versions agree
+        bool agree = true;
+        for (int i = 0; i < batches.size(); i++) {
+            agree &= batches[i].detours == expected[i].detours && batches[i].shifts == expected[i].shifts && batches[i].violations == expected[i].violations;
+        }
+
+        std::cout << instance << ": " << positions << " positions, scalar " << Debugger::formatDouble(scalar, 2) << " ns, vectorized " << Debugger::formatDouble(vectorized, 2) << " ns per position";
+        std::cout << " (" << Debugger::formatDouble(scalar / vectorized, 2) << "x)" << (agree ? "" : " MISMATCH") << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include "arena.h"
+
+// Size of the first block of every arena
+const std::size_t INITIAL_BLOCK_SIZE = 1 << 16;
+
+Arena& Arena::local() {
+    thread_local Arena arena;
+    return arena;
+}
+
+void* Arena::allocate(std::size_t bytes, std::size_t alignment) {
+    if (this->blocks.empty()) {
+        this->addBlock(std::max(INITIAL_BLOCK_SIZE, bytes + alignment));
+    }
+
+    while (true) {
+        // Align the current offset, and use it if the allocation fits
+        std::size_t aligned = (this->offset + alignment - 1) / alignment * alignment;
+        if (aligned + bytes <= this->blocks[this->block].second) {
+            this->offset = aligned + bytes;
+            return this->blocks[this->block].first.get() + aligned;
+        }
+
+        // Else continue in the next block, allocating one if it doesn't exist yet
+        if (this->block+1 == this->blocks.size()) {
+            this->addBlock(std::max(2 * this->blocks[this->block].second, bytes + alignment));
+        }
+        this->block++;
+        this->offset = 0;
+    }
+}
+
+std::pair<std::size_t, std::size_t> Arena::mark() {
+    return std::make_pair(this->block, this->offset);
+}
+
+void Arena::rewind(std::pair<std::size_t, std::size_t> position) {
+    this->block = position.first;
+    this->offset = position.second;
+
+    // When fully rewound, merge several blocks into a single large enough one
+    if (this->block == 0 && this->offset == 0 && this->blocks.size() > 1) {
+        std::size_t size = 0;
+        for (auto && [memory, blockSize] : this->blocks) {
+            size += blockSize;
+        }
+        this->blocks.clear();
+        this->addBlock(size);
+    }
+}
+
+void Arena::addBlock(std::size_t size) {
+    this->blocks.push_back(std::make_pair(std::make_unique<char[]>(size), size));
+}
+
+ArenaScope::ArenaScope() {
+    this->position = Arena::local().mark();
+}
+
+ArenaScope::~ArenaScope() {
+    Arena::local().rewind(this->position);
+}
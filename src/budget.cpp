@@ -0,0 +1,75 @@
+#include "budget.h"
+
+BudgetController::BudgetController(int cores) {
+    this->cores = std::max(1, cores);
+}
+
+int BudgetController::enroll(double deadline) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->slots.push_back({deadline, INT_MAX, 0, 0, 0, false, false});
+    return this->slots.size() - 1;
+}
+
+bool BudgetController::report(int slot, int bestCost, double elapsed) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    BudgetSlot& search = this->slots[slot];
+
+    // Smooth the relative improvement per second since the last report
+    double interval = elapsed - search.lastReport;
+    if (search.bestCost != INT_MAX && interval > 0) {
+        double improvement = (double)(search.bestCost - bestCost) / search.bestCost;
+        search.rate = (1.0 - RATE_SMOOTHING) * search.rate + RATE_SMOOTHING * improvement / interval;
+    }
+    if (bestCost < search.bestCost) {
+        search.bestCost = bestCost;
+        search.lastImprovement = elapsed;
+    }
+    search.lastReport = elapsed;
+
+    // Stop the search if it ran long enough, and went without a new best solution for a large part of that time
+    if (elapsed >= MINIMUM_BUDGET * search.deadline && elapsed - search.lastImprovement >= STAGNATION_FRACTION * elapsed) {
+        search.stopped = true;
+    }
+    return !search.stopped;
+}
+
+int BudgetController::share(int slot) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    // Every running search keeps a core, and the rest is left over
+    int running = 0;
+    double totalRate = 0;
+    for (BudgetSlot& search : this->slots) {
+        if (!search.finished) {
+            running++;
+            totalRate += search.rate;
+        }
+    }
+    int spare = std::max(0, this->cores - running);
+
+    // Split the cores left over by improvement rate, or evenly if no search is improving
+    double part = (totalRate > 0) ? this->slots[slot].rate / totalRate : 1.0 / std::max(1, running);
+    return 1 + (int)(spare * part);
+}
+
+void BudgetController::finish(int slot, double elapsed) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    BudgetSlot& search = this->slots[slot];
+    search.finished = true;
+
+    // Count the time left of searches that stopped on convergence
+    if (search.stopped) {
+        this->stopped++;
+        this->saved += std::max(0.0, search.deadline - elapsed);
+    }
+}
+
+int BudgetController::stoppedEarly() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->stopped;
+}
+
+double BudgetController::savedSeconds() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->saved;
+}
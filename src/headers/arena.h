@@ -0,0 +1,104 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+class Arena {
+    public:
+    /**
+     * @brief Get the arena of the current thread.
+     *
+     * @return Thread-local arena
+     */
+    static Arena& local();
+
+    /**
+     * @brief Bump-allocate memory from the arena.
+     * Only allocates from the heap if none of the arena's blocks have room left.
+     *
+     * @param bytes Number of bytes to allocate
+     * @param alignment Alignment of the allocation
+     * @return Pointer to the allocated memory
+     */
+    void* allocate(std::size_t bytes, std::size_t alignment);
+
+    /**
+     * @brief Get the current position of the arena, to later rewind to.
+     *
+     * @return Current position
+     */
+    std::pair<std::size_t, std::size_t> mark();
+
+    /**
+     * @brief Release everything allocated since the given position.
+     * Rewinding to the very start merges all blocks into one, so the next round fits without the heap.
+     *
+     * @param position Position given by mark
+     */
+    void rewind(std::pair<std::size_t, std::size_t> position);
+
+    private:
+    std::vector<std::pair<std::unique_ptr<char[]>, std::size_t>> blocks;
+    std::size_t block = 0, offset = 0;
+
+    /**
+     * @brief Allocate a new block from the heap.
+     *
+     * @param size Size of the block
+     */
+    void addBlock(std::size_t size);
+};
+
+class ArenaScope {
+    public:
+    /**
+     * @brief Start a scope on the thread-local arena.
+     * Everything allocated within the scope is released when it ends, so scopes have to be nested.
+     */
+    ArenaScope();
+
+    /**
+     * @brief End the scope, rewinding the arena to where it began.
+     */
+    ~ArenaScope();
+
+    private:
+    std::pair<std::size_t, std::size_t> position;
+};
+
+/**
+ * @brief Stateless allocator using the thread-local arena.
+ * Deallocation is a no-op, memory is released when the surrounding ArenaScope ends.
+ *
+ * @note Containers using it may not outlive the scope they were filled in, and may only grow on that thread.
+ */
+template<typename T>
+struct ArenaAllocator {
+    typedef T value_type;
+
+    ArenaAllocator() = default;
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>&) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(Arena::local().allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, std::size_t) {}
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>&) const {
+        return true;
+    }
+
+    template<typename U>
+    bool operator!=(const ArenaAllocator<U>&) const {
+        return false;
+    }
+};
+
+// Flat vector living in the thread-local arena
+template<typename T>
+using ScratchVector = std::vector<T, ArenaAllocator<T>>;
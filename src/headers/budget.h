@@ -0,0 +1,97 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <climits>
+#include <algorithm>
+
+// Iterations between two reports of a search to the budget controller
+const int BUDGET_INTERVAL = 100;
+
+// Fraction of its time a search always runs, before it may be stopped on stagnation
+const double MINIMUM_BUDGET = 0.25;
+
+// A search has converged once it went this fraction of its elapsed time without a new best solution
+const double STAGNATION_FRACTION = 0.5;
+
+// Smoothing factor of the improvement rate of a search, the weight of the latest report
+const double RATE_SMOOTHING = 0.2;
+
+struct {
+    double deadline;
+    int bestCost;
+    double lastReport;
+    double lastImprovement;
+    double rate;
+    bool finished;
+    bool stopped;
+} typedef BudgetSlot;
+
+class BudgetController {
+    public:
+    /**
+     * @brief Create a controller sharing the cores among searches running concurrently.
+     * Searches report their progress every BUDGET_INTERVAL iterations, and are stopped once converged,
+     * while the cores left over are given to the searches that are improving fastest.
+     *
+     * @param cores Number of cores to share
+     */
+    BudgetController(int cores);
+
+    /**
+     * @brief Register a starting search.
+     *
+     * @param deadline Time of the search in seconds
+     * @return Slot of the search, to report with
+     */
+    int enroll(double deadline);
+
+    /**
+     * @brief Report the progress of a search.
+     *
+     * @param slot Slot of the search
+     * @param bestCost Cost of its best solution so far
+     * @param elapsed Seconds since the search started
+     * @return true if the search should continue,
+     * @return false if it has converged and should stop
+     */
+    bool report(int slot, int bestCost, double elapsed);
+
+    /**
+     * @brief Get the number of cores a search may use, one plus its part of the cores left over by the other searches,
+     * proportional to its improvement rate.
+     *
+     * @param slot Slot of the search
+     * @return Number of cores, at least one
+     */
+    int share(int slot);
+
+    /**
+     * @brief Deregister a finished search, freeing its cores.
+     *
+     * @param slot Slot of the search
+     * @param elapsed Seconds the search ran for
+     */
+    void finish(int slot, double elapsed);
+
+    /**
+     * @brief Get the number of searches stopped before their deadline.
+     *
+     * @return Number of searches
+     */
+    int stoppedEarly();
+
+    /**
+     * @brief Get the total time saved by stopping searches before their deadline.
+     *
+     * @return Time in seconds
+     */
+    double savedSeconds();
+
+    private:
+    int cores;
+    std::vector<BudgetSlot> slots;
+    int stopped = 0;
+    double saved = 0;
+    std::mutex mutex;
+};
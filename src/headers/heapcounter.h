@@ -0,0 +1,23 @@
+#pragma once
+
+class HeapCounter {
+    public:
+    /**
+     * @brief Get the number of heap allocations (calls to operator new) made by the current thread,
+     * including those made by pool workers running indices of parallel loops it waited for.
+     *
+     * @return Number of allocations
+     */
+    static long long allocations();
+
+    /**
+     * @brief Count allocations made on behalf of the current thread by other threads.
+     *
+     * @param allocations Number of allocations to add
+     */
+    static void credit(long long allocations);
+
+    private:
+    // This is a static class, prevent class creation
+    HeapCounter();
+};
@@ -1,8 +1,26 @@
 #pragma once
 
-#include <map>
+#include <type_traits>
 
+#include "arena.h"
+#include "kernel.h"
+#include "insertioncache.h"
 #include "solution.h"
+#include "threadpool.h"
+
+struct {
+    int cost;
+    int state;
+    int callIndex;
+    CallDetails insertion;
+    long long order;
+} typedef BeamCandidate;
+
+// Arena-backed (cost, callDetail) insertion positions of a call, for a single vehicle and for every vehicle.
+// Like every other container returned here, they live in the thread-local arena and are only valid
+// within the ArenaScope they were created in (operators open one per application)
+typedef ScratchVector<std::pair<int, CallDetails>> Insertions;
+typedef ScratchVector<Insertions> VehicleInsertions;
 
 /**
  * @brief Remove similar calls using precalculated relatedness 
@@ -13,7 +31,7 @@
  * @param rng Random number generator engine
  * @return Vector of callIndices removed
  */
-std::vector<int> removeSimilar(int callsToRemove, Solution* solution, std::default_random_engine& rng);
+ScratchVector<int> removeSimilar(int callsToRemove, Solution* solution, Xoshiro256& rng);
 
 /**
  * @brief Remove most costly calls from the current solution.
@@ -23,7 +41,7 @@ std::vector<int> removeSimilar(int callsToRemove, Solution* solution, std::defau
  * @param rng Random number generator engine
  * @return Vector of callIndices removed
  */
-std::vector<int> removeCostly(int callsToRemove, Solution* solution, std::default_random_engine& rng);
+ScratchVector<int> removeCostly(int callsToRemove, Solution* solution, Xoshiro256& rng);
 
 /**
  * @brief Remove random calls from the current solution.
@@ -33,64 +51,111 @@ std::vector<int> removeCostly(int callsToRemove, Solution* solution, std::defaul
  * @param rng Random number generator engine
  * @return Vector of callIndices removed
  */
-std::vector<int> removeRandom(int callsToRemove, Solution* solution, std::default_random_engine& rng);
+ScratchVector<int> removeRandom(int callsToRemove, Solution* solution, Xoshiro256& rng);
 
 /**
  * @brief Insert all given calls into their best possible positions.
  * Calls are inserted in a greedy-order.
  * 
- * @param callIndices Set of calls to insert
+ * @param callIndices Sorted calls to insert
  * @param solution Solution to insert into
  */
-void insertGreedy(std::set<int>& callIndices, Solution* solution);
+void insertGreedy(ScratchVector<int>& callIndices, Solution* solution);
 
 /**
  * @brief Insert all given calls into their best possible positions.
  * Calls are inserted in a regret-k order.
  * 
- * @param callIndices Set of calls to insert
+ * @param callIndices Sorted calls to insert
  * @param solution Solution to insert into
  * @param k Regret-k parameter
  */
-void insertRegret(std::set<int>& callIndices, Solution* solution, int k);
+void insertRegret(ScratchVector<int>& callIndices, Solution* solution, int k);
 
 /**
  * @brief Insert all given calls into their best possible positions.
  * Calls are inserted in a greedy order, but using beamsearch to widen the search space.
+ * Beam states and their candidate calls are expanded concurrently on the shared thread pool.
  * 
  * @note Beam width of 1 equals greedy insertion
  * 
- * @param callIndices Set of calls to insert
+ * @param callIndices Sorted calls to insert
  * @param solution Solution to insert into
  * @param width Beam width (amount of solutions kept between each insertion iteration)
  */
-void insertBeam(std::set<int>& callIndices, Solution* solution, int width);
+void insertBeam(ScratchVector<int>& callIndices, Solution* solution, int width);
 
 /**
  * @brief Insert all given calls into a random, feasible position.
  * 
- * @param callIndices Set of calls to insert
+ * @param callIndices Sorted calls to insert
  * @param solution Solution to insert into
  */
-void insertRandom(std::set<int>& callIndices, Solution* solution, std::default_random_engine& rng);
+void insertRandom(ScratchVector<int>& callIndices, Solution* solution, Xoshiro256& rng);
+
+/**
+ * @brief Calculate all different insertion positions for each of the given calls.
+ * 
+ * @param callIndices Calls to find insertions for
+ * @param solution Solution to find insertion positions in
+ * @param sort Sort the positions by cost in an ascending order 
+ * @param limit Number of cheapest insertions needed per vehicle, or 0 for all of them
+ * @param prunedBounds If given, run in greedy mode, storing each call's bound of skipped vehicles (see calculateFeasibleInsertions)
+ * @return Flat table of insertions for each vehicle, indexed by callIndex-1, empty for calls not given
+ */
+ScratchVector<VehicleInsertions> calculateAllFeasibleInsertions(ScratchVector<int>& callIndices, Solution* solution, bool sort, int limit = 0, ScratchVector<int>* prunedBounds = nullptr);
 
 /**
  * @brief Calculate all different insertion positions for a given call.
+ * Vehicles too small to carry the call are skipped.
+ * In greedy mode, only the best insertion is guaranteed to be found: vehicles are visited by their lower bound,
+ * and those whose bound exceeds the best insertion found so far are skipped, leaving them empty.
  * 
  * @param callIndex Given call to find insertions for
  * @param solution Solution to find insertion positions in
  * @param sort Sort the positions by cost in an ascending order 
+ * @param limit Number of cheapest insertions needed per vehicle, or 0 for all of them
+ * @param prunedBound If given, run in greedy mode, storing the lowest bound of the skipped vehicles (or INT_MAX)
  * @return Vector of vectors of (cost, callDetail) for each insertion position for each vehicle
  */
-std::vector<std::vector<std::pair<int, CallDetails>>> calculateFeasibleInsertions(int callIndex, Solution* solution, bool sort);
+VehicleInsertions calculateFeasibleInsertions(int callIndex, Solution* solution, bool sort, int limit = 0, int* prunedBound = nullptr);
+
+/**
+ * @brief Calculate a lower bound of the increase in cost when inserting a call into a vehicle.
+ * 
+ * @param vehicleIndex Given vehicle to insert into
+ * @param callIndex Given call to insert
+ * @param solution Solution to insert into
+ * @return Lower bound of the change in cost
+ */
+int insertionLowerBound(int vehicleIndex, int callIndex, Solution* solution);
+
+/**
+ * @brief Hand the insertions into a vehicle over to an interchangeable empty vehicle, if the vehicle was empty
+ * and just had its first call inserted. Only one empty vehicle of each equivalence class is evaluated,
+ * so its insertions stay available through the next one.
+ * 
+ * @note Must be called before the vehicle's own insertions are recalculated.
+ * 
+ * @param feasibleInsertions Flat table of insertions, indexed by call
+ * @param callIndices Calls still to be inserted
+ * @param vehicleIndex Vehicle which was inserted into
+ * @param solution Solution which was inserted into
+ */
+void handOverEmptyInsertions(ScratchVector<VehicleInsertions>& feasibleInsertions, ScratchVector<int>& callIndices, int vehicleIndex, Solution* solution);
 
 /**
  * @brief Calculate all different insertion positions for a given call, inside a single vehicle.
+ * If the problem is granular, only positions adjacent to related or near stops are considered.
+ * The cost of every position is computed up front, so with a limit the (expensive) feasibility check
+ * runs from the cheapest position on, only until enough feasible ones are found.
  * 
  * @param vehicleIndex Given vehicle to find insertion in
  * @param callIndex Given call to find insertions for
  * @param solution Solution to find insertion positions in
- * @param sort Sort the positions by cost in an ascending order 
+ * @param sort Sort the positions by cost in an ascending order (always sorted when given a limit)
+ * @param limit Number of cheapest feasible insertions needed, or 0 for all of them
+ * @param cutoff Only consider insertions with a cost of at most this
  * @return Vector of (cost, callDetail) for each insertion position in the vehicle
  */
-std::vector<std::pair<int, CallDetails>> greedyFeasibleInsertions(int vehicleIndex, int callIndex, Solution* solution, bool sort);
\ No newline at end of file
+Insertions greedyFeasibleInsertions(int vehicleIndex, int callIndex, Solution* solution, bool sort, int limit = 0, int cutoff = INT_MAX);
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <climits>
+
+#include "arena.h"
+#include "solution.h"
+
+struct {
+    long long version;
+    int limit;
+    int cutoff;
+    std::vector<std::pair<int, CallDetails>> insertions;
+} typedef CachedInsertions;
+
+// Number of independently locked parts of the insertion cache of every solution
+const int INSERTION_CACHE_SHARDS = 16;
+
+class InsertionCache {
+    public:
+    /**
+     * @brief Construct an empty cache of insertions for every (call, vehicle) pair of a problem.
+     * Consecutive pairs are locked by different shards, so threads inserting a call into several vehicles rarely wait on each other.
+     *
+     * @param problem Problem the cached solutions belong to
+     * @param shards Number of independently locked parts
+     */
+    InsertionCache(Problem* problem, int shards);
+
+    /**
+     * @brief Look up the best insertions of a call into a vehicle, computed while its route had the given version.
+     * Costs are kept relative to the cost of the solution, as the rest of the solution may have changed since.
+     *
+     * @param vehicleIndex Vehicle to insert into
+     * @param callIndex Call to insert
+     * @param version Current version of the vehicle's route
+     * @param limit Number of cheapest insertions needed
+     * @param cutoff Highest cost needed (INT_MAX if unlimited)
+     * @param baseCost Current cost of the solution
+     * @param insertions Vector to write the found insertions (cost, callDetail) into
+     * @return true if the cached insertions cover the request,
+     * @return false otherwise
+     */
+    bool lookup(int vehicleIndex, int callIndex, long long version, int limit, int cutoff, int baseCost, ScratchVector<std::pair<int, CallDetails>>& insertions);
+
+    /**
+     * @brief Store the best insertions of a call into a vehicle, computed while its route had the given version.
+     *
+     * @param vehicleIndex Vehicle inserted into
+     * @param callIndex Call inserted
+     * @param version Version of the vehicle's route
+     * @param limit Number of cheapest insertions which were searched for
+     * @param cutoff Highest cost which was searched for (INT_MAX if unlimited)
+     * @param baseCost Cost of the solution the insertions were found in
+     * @param insertions Found insertions (cost, callDetail), sorted by cost
+     */
+    void store(int vehicleIndex, int callIndex, long long version, int limit, int cutoff, int baseCost, ScratchVector<std::pair<int, CallDetails>>& insertions);
+
+    /**
+     * @brief Get the number of lookups answered by the cache.
+     *
+     * @return Number of hits
+     */
+    long long hits();
+
+    /**
+     * @brief Get the number of lookups which had to be computed.
+     *
+     * @return Number of misses
+     */
+    long long misses();
+
+    private:
+    int noVehicles;
+    int noShards;
+    std::vector<CachedInsertions> entries;
+    std::unique_ptr<std::mutex[]> mutexes;
+    std::atomic<long long> hitCount, missCount;
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <random>
+#include <vector>
+#include <memory>
+
+#include "solution.h"
+#include "operator.h"
+
+struct {
+    Solution bestSolution;
+    Solution incumbent;
+    Operator* neighbourOperator;
+    Xoshiro256 rng;
+    int batchSize;
+    int iteration;
+    int lastBestFound;
+    int iterfound;
+    double timefound;
+} typedef SearchState;
+
+// Iterations every island runs between two migrations
+const int MIGRATION_INTERVAL = 500;
+
+// Iterations every replica of parallel tempering runs between two rounds of exchanges
+const int EXCHANGE_INTERVAL = 100;
+
+// Probability of accepting an average worse neighbour at the hottest and the coldest temperature of parallel tempering
+const double HOTTEST_ACCEPTANCE = 0.8;
+const double COLDEST_ACCEPTANCE = 0.001;
+
+class EliteBoard {
+    public:
+    /**
+     * @brief Create a board holding the best solution of every island.
+     * Each island only writes its own slot during an epoch, and slots are only read between epochs,
+     * so the board needs no locks and migration does not depend on thread timing.
+     *
+     * @param islands Number of islands
+     */
+    EliteBoard(int islands);
+
+    /**
+     * @brief Publish a copy of an island's best solution, replacing its previous one.
+     *
+     * @param island Island publishing
+     * @param solution Best solution of the island
+     */
+    void publish(int island, Solution& solution);
+
+    /**
+     * @brief Read the solution last published by an island.
+     *
+     * @param island Island to read
+     * @return Published solution, nullptr if none yet
+     */
+    std::shared_ptr<Solution> read(int island);
+
+    /**
+     * @brief Get the cheapest solution published by any island.
+     *
+     * @return Best published solution, the lowest island winning ties
+     */
+    std::shared_ptr<Solution> best();
+
+    private:
+    std::vector<std::shared_ptr<Solution>> slots;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+
+#include "solution.h"
+
+struct {
+    std::vector<int> departures;
+    std::vector<int> timeToOrigin;
+    std::vector<int> costToOrigin;
+    std::vector<int> timeFromOrigin;
+    std::vector<int> costFromOrigin;
+    std::vector<int> legTimes;
+    std::vector<int> legCosts;
+    std::vector<int> slack;
+    int windowStart;
+    int windowEnd;
+    int serviceTime;
+    int count;
+
+    std::vector<int> detours;
+    std::vector<int> shifts;
+    std::vector<int> violations;
+} typedef PickupBatch;
+
+// Violation flags of a pickup position
+const int PICKUP_LATE = 1;
+const int SLACK_EXCEEDED = 2;
+
+// Whether the kernel is built with AVX2, without which gathering a batch costs more than evaluating it saves
+#if defined(__AVX2__)
+const bool PICKUP_KERNEL_AVX2 = true;
+#else
+const bool PICKUP_KERNEL_AVX2 = false;
+#endif
+
+// Least number of pickup positions worth gathering into a batch
+const int PICKUP_BATCH_MINIMUM = 32;
+
+/**
+ * @brief Gather everything needed to evaluate the first count pickup positions of a call in a vehicle
+ * into contiguous arrays.
+ *
+ * @param vehicleIndex Vehicle to insert into
+ * @param callIndex Call to insert
+ * @param count Number of pickup positions, starting from the front of the route
+ * @param solution Solution to gather route profile from
+ * @param batch Batch to fill
+ */
+void gatherPickupPositions(int vehicleIndex, int callIndex, int count, Solution* solution, PickupBatch& batch);
+
+/**
+ * @brief Evaluate inserting only the pickup at every position of a batch.
+ * Computes the detour cost, the delay of the arrival at the next stop, and whether the pickup
+ * is late or the delay exceeds the slack of the rest of the route.
+ * Uses AVX2 or portable vector extensions for 8 positions at a time, when available.
+ *
+ * @note A delivery inserted afterwards only adds delay, so flagged positions can never be feasible.
+ *
+ * @param batch Gathered batch, results are written into its detours, shifts and violations
+ */
+void evaluatePickupPositions(PickupBatch& batch);
+
+/**
+ * @brief Scalar version of evaluatePickupPositions, evaluating positions [begin, end) one at a time.
+ *
+ * @param batch Gathered batch, results are written into its detours, shifts and violations
+ * @param begin First position to evaluate
+ * @param end One past the last position to evaluate
+ */
+void evaluatePickupPositionsScalar(PickupBatch& batch, int begin, int end);
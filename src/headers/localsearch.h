@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+#include <optional>
+
+#include "arena.h"
+#include "solution.h"
+#include "segment.h"
+
+class LocalOptimizer {
+    public:
+    /**
+     * @brief Prepare a first-improvement local search on a solution.
+     *
+     * @param solution Solution to improve in place, which has to be feasible
+     */
+    LocalOptimizer(Solution* solution);
+
+    /**
+     * @brief Apply improving relocate, pair swap and Or-opt moves until none is left.
+     * Every move is evaluated in constant time from the route segments, and calls are skipped (don't-look bits)
+     * until one of the routes they are in changes.
+     *
+     * @return Number of improving moves applied
+     */
+    int run();
+
+    private:
+    /**
+     * @brief Move a call to the first cheaper position, in its own route, another vehicle or outsourced.
+     *
+     * @param callIndex Call to relocate
+     * @return true if the call was moved,
+     * @return false otherwise
+     */
+    bool relocate(int callIndex);
+
+    /**
+     * @brief Exchange a call with the first call of another vehicle for which it is cheaper, each taking the other's positions.
+     *
+     * @param callIndex Call to swap
+     * @return true if the calls were swapped,
+     * @return false otherwise
+     */
+    bool swap(int callIndex);
+
+    /**
+     * @brief Move the stops from the pickup to the delivery of a call as one block within its route, if they hold whole calls.
+     *
+     * @param callIndex Call starting the block
+     * @return true if the block was moved,
+     * @return false otherwise
+     */
+    bool orOpt(int callIndex);
+
+    /**
+     * @brief Get the segments of a route, summarizing them if not done since the route last changed.
+     *
+     * @param vehicleIndex Vehicle of the route
+     * @return Segments of the route
+     */
+    RouteSegments& segments(int vehicleIndex);
+
+    /**
+     * @brief Mark the route of a vehicle as changed, so its segments are rebuilt and its calls looked at again.
+     *
+     * @param vehicleIndex Vehicle of the changed route
+     */
+    void changed(int vehicleIndex);
+
+    Solution* solution;
+    std::vector<bool> dontLook;
+    std::vector<std::optional<RouteSegments>> routeSegments;
+
+    // Route of the relocated call without it, and its segments, reused between calls
+    std::vector<int> reducedRoute;
+    std::optional<RouteSegments> reducedSegments;
+};
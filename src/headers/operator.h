@@ -1,11 +1,20 @@
 #pragma once
 
+#include <array>
+#include <cmath>
+#include <memory>
+#include <optional>
+
 #include "problem.h"
 #include "solution.h"
 #include "heuristics.h"
+#include "segment.h"
+#include "localsearch.h"
 
 class Operator {
     public:
+    virtual ~Operator() = default;
+
     /**
      * @brief Apply operator to solution.
      * 
@@ -14,7 +23,52 @@ class Operator {
      * @param rng Random number generator Engine
      * @return Neighbour solution
      */
-    virtual Solution apply(Solution* solution, int iteration, std::default_random_engine& rng) = 0;
+    virtual Solution apply(Solution* solution, int iteration, Xoshiro256& rng) = 0;
+
+    /**
+     * @brief Apply operator to solution several times concurrently, and keep the best neighbour.
+     * Every neighbour gets its own random number stream split from the given one, so the result does not depend on the threads.
+     * 
+     * @note A batch of one is exactly the same as apply.
+     * 
+     * @param solution Solution to apply operator on
+     * @param iteration Current iteration
+     * @param batchSize Number of neighbours to generate
+     * @param rng Random number generator Engine
+     * @return Cheapest feasible neighbour solution, the first one if none is feasible
+     */
+    virtual Solution applyBatch(Solution* solution, int iteration, int batchSize, Xoshiro256& rng);
+
+    /**
+     * @brief Tell the operator how much of the search is left, before it is applied.
+     * Operators that don't adapt to the deadline ignore it.
+     * 
+     * @param remaining Fraction of the search left, from 1 down to 0
+     * @param secondsLeft Wall time left in seconds, infinite if the search is not timed
+     */
+    virtual void setDeadline(double remaining, double secondsLeft);
+
+    protected:
+    /**
+     * @brief Get the best neighbour of a batch.
+     * 
+     * @param neighbours Generated neighbour solutions
+     * @return Index of the cheapest feasible neighbour, 0 if none is feasible
+     */
+    static int bestOfBatch(std::vector<Solution>& neighbours);
+
+    /**
+     * @brief Apply an operator and measure how long it took and how many calls it moved.
+     * 
+     * @param neighbourOperator Operator to apply
+     * @param solution Solution to apply the operator on
+     * @param iteration Current iteration
+     * @param rng Random number generator Engine
+     * @param seconds Wall time of the application, written to
+     * @param calls Calls moved by the application, written to
+     * @return Neighbour solution
+     */
+    static Solution timedApply(Operator* neighbourOperator, Solution* solution, int iteration, Xoshiro256& rng, double& seconds, int& calls);
 };
 
 class UniformOperator : public Operator {
@@ -23,7 +77,7 @@ class UniformOperator : public Operator {
      * @brief Create a Uniform Operator.
      * Applying this has a uniform probability of applying any operator it contains.
      * 
-     * @param operators Operators to apply, with a uniform probability each
+     * @param operators Operators to apply, with a uniform probability each, taking ownership of them
      */
     UniformOperator(std::vector<Operator*> operators);
 
@@ -36,10 +90,10 @@ class UniformOperator : public Operator {
      * @param rng Random number generator Engine
      * @return Neighbour solution
      */
-    Solution apply(Solution* solution, int iteration, std::default_random_engine& rng);
+    Solution apply(Solution* solution, int iteration, Xoshiro256& rng);
 
     private:
-    std::vector<Operator*> operators;
+    std::vector<std::unique_ptr<Operator>> operators;
 };
 
 class WeightedOperator : public Operator {
@@ -48,7 +102,7 @@ class WeightedOperator : public Operator {
      * @brief Create a Weighted Operator.
      * Applying samples a weighted probability distribution and applies the selected operator it contains.
      * 
-     * @param operators Operators to apply, with a the given probability weight
+     * @param operators Operators to apply, with a the given probability weight, taking ownership of them
      */
     WeightedOperator(std::vector<std::pair<Operator*, double>> operators);
 
@@ -61,11 +115,45 @@ class WeightedOperator : public Operator {
      * @param rng Random number generator Engine
      * @return Neighbour solution
      */
-    Solution apply(Solution* solution, int iteration, std::default_random_engine& rng);
+    Solution apply(Solution* solution, int iteration, Xoshiro256& rng);
 
     private:
-    std::vector<Operator*> operators;
+    std::vector<std::unique_ptr<Operator>> operators;
     std::vector<double> weights;
+    AliasTable table;
+};
+
+class OperatorCost {
+    public:
+    /**
+     * @brief Record the wall time of an application of an operator.
+     * 
+     * @param calls Number of calls the application moved, 0 if the operator doesn't sample it
+     * @param seconds Wall time of the application
+     */
+    void record(int calls, double seconds);
+
+    /**
+     * @brief Predict the wall time of an application, from a least squares fit of the time against the calls moved.
+     * 
+     * @param calls Number of calls to move
+     * @return Predicted wall time in seconds, 0 if never applied
+     */
+    double predict(double calls);
+
+    /**
+     * @brief Get the number of recorded applications.
+     * 
+     * @return Number of applications
+     */
+    long long applications();
+
+    private:
+    long long count = 0;
+    double sumCalls = 0;
+    double sumSeconds = 0;
+    double sumCallsSquared = 0;
+    double sumCallsSeconds = 0;
 };
 
 class AdaptiveOperator : public Operator {
@@ -75,9 +163,14 @@ class AdaptiveOperator : public Operator {
      * It adaptively updates the probability for each sub-operator to be called,
      * calculated from the efficacy of each of them.
      * 
-     * @param operators Operators to apply, with a calculated adaptive probability
+     * @note If time aware, the efficacy is taken per predicted second of wall time, increasingly so towards the deadline,
+     * and operators predicted to take longer than the time left are barely chosen. This only applies while the search is bounded by time,
+     * as told by setDeadline, such that searches bounded by iterations do not depend on timing.
+     * 
+     * @param operators Operators to apply, with a calculated adaptive probability, taking ownership of them
+     * @param timeAware Whether to credit the operators by their wall time as well
      */
-    AdaptiveOperator(std::vector<Operator*> operators);
+    AdaptiveOperator(std::vector<Operator*> operators, bool timeAware = false);
 
     /**
      * @brief Apply an operator to solution.
@@ -88,17 +181,45 @@ class AdaptiveOperator : public Operator {
      * @param rng Random number generator Engine
      * @return Neighbour solution
      */
-    Solution apply(Solution* solution, int iteration, std::default_random_engine& rng);
+    Solution apply(Solution* solution, int iteration, Xoshiro256& rng);
+
+    /**
+     * @brief Apply several operators to solution concurrently, and keep the best neighbour.
+     * Operators are drawn independently based on the adaptive scoring system, and every neighbour is scored.
+     * 
+     * @param solution Solution to apply operators on
+     * @param iteration Current iteration
+     * @param batchSize Number of neighbours to generate
+     * @param rng Random number generator Engine
+     * @return Cheapest feasible neighbour solution, the first one if none is feasible
+     */
+    Solution applyBatch(Solution* solution, int iteration, int batchSize, Xoshiro256& rng);
+
+    /**
+     * @brief Store how much of the search is left, to weigh the operators' wall time by.
+     * 
+     * @param remaining Fraction of the search left, from 1 down to 0
+     * @param secondsLeft Wall time left in seconds, infinite if the search is not timed
+     */
+    void setDeadline(double remaining, double secondsLeft);
 
     // Public for debugging purposes
     std::vector<double> weights;
     int lastOperatorUsed;
 
     private:
-    std::vector<Operator*> operators;
+    std::vector<std::unique_ptr<Operator>> operators;
     std::vector<int> scores;
     std::vector<int> uses;
 
+    // Wall time of every operator, and how much of the search is left
+    bool timeAware;
+    std::vector<OperatorCost> costs;
+    double averageCalls = 0;
+    long long sampledApplications = 0;
+    double remaining = 1.0;
+    double secondsLeft = INFINITY;
+
     // HashSet and HashFunction for solutions
     struct SolutionHash {
         size_t operator()(const Solution& solution) const {
@@ -117,6 +238,9 @@ class AdaptiveOperator : public Operator {
     };
     std::unordered_set<Solution, SolutionHash> seenSolutions;
 
+    // Table sampling the weights in constant time, rebuilt whenever they change
+    AliasTable table;
+
     int bestCost = 0;
     double r = 0.2;
 
@@ -125,12 +249,140 @@ class AdaptiveOperator : public Operator {
      */
     void update();
 
+    /**
+     * @brief Record the measured wall time of an operator.
+     * 
+     * @param operatorIndex Operator applied
+     * @param seconds Wall time of the application
+     * @param calls Calls moved by the application
+     */
+    void recordCost(int operatorIndex, double seconds, int calls);
+
+    /**
+     * @brief Score an operator based on the neighbour solution it generated.
+     * 
+     * @param operatorIndex Operator used
+     * @param solution Solution the operator was applied on
+     * @param newSolution Generated neighbour solution
+     */
+    void score(int operatorIndex, Solution* solution, Solution& newSolution);
+
     /**
      * @brief Reset each operator's weight.
      */
     void reset();
 };
 
+// Features of the search state the bandit operator conditions on, including a constant term
+const int BANDIT_FEATURES = 5;
+
+// Iterations without a new best solution after which the bandit operator considers the search fully stagnated
+const int BANDIT_STAGNATION = 1000;
+
+typedef std::array<double, BANDIT_FEATURES> BanditContext;
+
+class BanditOperator : public Operator {
+    public:
+    /**
+     * @brief Create a Bandit Operator.
+     * It draws sub-operators proportionally to an upper confidence bound on their reward per second (LinUCB), with the reward predicted
+     * linearly from the time left, the iterations since the last best solution, the fraction of outsourced calls and the last removal size.
+     * The reward of an application is the relative improvement of the solution in percent, plus one for a new best solution.
+     * 
+     * @param operators Operators to choose from, taking ownership of them
+     * @param exploration Width of the confidence bound, higher explores more
+     */
+    BanditOperator(std::vector<Operator*> operators, double exploration = 0.5);
+
+    /**
+     * @brief Apply an operator drawn by its upper confidence bound in the current search state.
+     * 
+     * @param solution Solution to apply an operator on
+     * @param iteration Current iteration
+     * @param rng Random number generator Engine
+     * @return Neighbour solution
+     */
+    Solution apply(Solution* solution, int iteration, Xoshiro256& rng);
+
+    /**
+     * @brief Apply several operators to solution concurrently, and keep the best neighbour.
+     * Operators are drawn independently by their upper confidence bound in the current search state, and every outcome is learned from.
+     * 
+     * @param solution Solution to apply operators on
+     * @param iteration Current iteration
+     * @param batchSize Number of neighbours to generate
+     * @param rng Random number generator Engine
+     * @return Cheapest feasible neighbour solution, the first one if none is feasible
+     */
+    Solution applyBatch(Solution* solution, int iteration, int batchSize, Xoshiro256& rng);
+
+    /**
+     * @brief Store how much of the search is left, as a feature of the search state.
+     * 
+     * @param remaining Fraction of the search left, from 1 down to 0
+     * @param secondsLeft Wall time left in seconds, infinite if the search is not timed
+     */
+    void setDeadline(double remaining, double secondsLeft);
+
+    // Public for debugging purposes
+    int lastOperatorUsed;
+
+    private:
+    std::vector<std::unique_ptr<Operator>> operators;
+    double exploration;
+
+    // Per operator, the inverse of the regularized feature covariance, and the features summed weighted by reward
+    std::vector<std::array<BanditContext, BANDIT_FEATURES>> inverses;
+    std::vector<BanditContext> rewardSums;
+
+    // Table sampling the operators proportionally to their bounds
+    AliasTable table;
+
+    // State of the search, as far as the operator sees it
+    double remaining = 1.0;
+    int bestCost = INT_MAX;
+    int lastBestFound = 0;
+    int lastCalls = 0;
+
+    // Total wall time and applications of every operator
+    std::vector<double> seconds;
+    std::vector<long long> uses;
+
+    /**
+     * @brief Get the features of the current search state, each in [0, 1].
+     * 
+     * @param solution Current solution
+     * @param iteration Current iteration
+     * @return Context of the search state
+     */
+    BanditContext context(Solution* solution, int iteration);
+
+    /**
+     * @brief Weigh the operators by their upper confidence bound on the reward per second in a context, and build the table sampling them.
+     * 
+     * @param features Context of the search state
+     */
+    void bound(BanditContext& features);
+
+    /**
+     * @brief Reward an operator for the neighbour it generated, and learn from it.
+     * 
+     * @param operatorIndex Operator used
+     * @param features Context the operator was chosen in
+     * @param solution Solution the operator was applied on
+     * @param newSolution Generated neighbour solution
+     * @param iteration Current iteration
+     * @param seconds Wall time of the application
+     * @param calls Calls moved by the application
+     */
+    void learn(int operatorIndex, BanditContext& features, Solution* solution, Solution& newSolution, int iteration, double seconds, int calls);
+
+    /**
+     * @brief Forget everything learned, and start with a fresh search state.
+     */
+    void reset();
+};
+
 class SimilarGreedyInsert : public Operator {
     public:
     /**
@@ -143,7 +395,7 @@ class SimilarGreedyInsert : public Operator {
      * @param rng Random number generator Engine
      * @return Neighbour solution
      */
-    Solution apply(Solution* solution, int iteration, std::default_random_engine& rng);
+    Solution apply(Solution* solution, int iteration, Xoshiro256& rng);
 };
 
 class SimilarRegretInsert : public Operator {
@@ -158,7 +410,7 @@ class SimilarRegretInsert : public Operator {
      * @param rng Random number generator Engine
      * @return Neighbour solution
      */
-    Solution apply(Solution* solution, int iteration, std::default_random_engine& rng);
+    Solution apply(Solution* solution, int iteration, Xoshiro256& rng);
 };
 
 class SimilarBeamInsert : public Operator {
@@ -173,7 +425,7 @@ class SimilarBeamInsert : public Operator {
      * @param rng Random number generator Engine
      * @return Neighbour solution
      */
-    Solution apply(Solution* solution, int iteration, std::default_random_engine& rng);
+    Solution apply(Solution* solution, int iteration, Xoshiro256& rng);
 };
 
 class CostlyGreedyInsert : public Operator {
@@ -188,7 +440,7 @@ class CostlyGreedyInsert : public Operator {
      * @param rng Random number generator Engine
      * @return Neighbour solution
      */
-    Solution apply(Solution* solution, int iteration, std::default_random_engine& rng);
+    Solution apply(Solution* solution, int iteration, Xoshiro256& rng);
 };
 
 class CostlyRegretInsert : public Operator {
@@ -203,7 +455,7 @@ class CostlyRegretInsert : public Operator {
      * @param rng Random number generator Engine
      * @return Neighbour solution
      */
-    Solution apply(Solution* solution, int iteration, std::default_random_engine& rng);
+    Solution apply(Solution* solution, int iteration, Xoshiro256& rng);
 };
 
 class CostlyBeamInsert : public Operator {
@@ -218,7 +470,7 @@ class CostlyBeamInsert : public Operator {
      * @param rng Random number generator Engine
      * @return Neighbour solution
      */
-    Solution apply(Solution* solution, int iteration, std::default_random_engine& rng);
+    Solution apply(Solution* solution, int iteration, Xoshiro256& rng);
 };
 
 class RandomGreedyInsert : public Operator {
@@ -233,7 +485,7 @@ class RandomGreedyInsert : public Operator {
      * @param rng Random number generator Engine
      * @return Neighbour solution
      */
-    Solution apply(Solution* solution, int iteration, std::default_random_engine& rng);
+    Solution apply(Solution* solution, int iteration, Xoshiro256& rng);
 };
 
 class RandomRegretInsert : public Operator {
@@ -248,7 +500,7 @@ class RandomRegretInsert : public Operator {
      * @param rng Random number generator Engine
      * @return Neighbour solution
      */
-    Solution apply(Solution* solution, int iteration, std::default_random_engine& rng);
+    Solution apply(Solution* solution, int iteration, Xoshiro256& rng);
 };
 
 class RandomBeamInsert : public Operator {
@@ -263,7 +515,92 @@ class RandomBeamInsert : public Operator {
      * @param rng Random number generator Engine
      * @return Neighbour solution
      */
-    Solution apply(Solution* solution, int iteration, std::default_random_engine& rng);
+    Solution apply(Solution* solution, int iteration, Xoshiro256& rng);
+};
+
+class RelocateCall : public Operator {
+    public:
+    /**
+     * @brief Relocate is an operator which
+     * randomly selects a call carried by one of our vehicles, and moves it
+     * to its best position in any other vehicle, evaluated through route segments.
+     * 
+     * @param solution Solution to apply operator on
+     * @param iteration Current iteration
+     * @param rng Random number generator Engine
+     * @return Neighbour solution
+     */
+    Solution apply(Solution* solution, int iteration, Xoshiro256& rng);
+};
+
+class SwapCalls : public Operator {
+    public:
+    /**
+     * @brief Swap is an operator which
+     * randomly selects a call carried by one of our vehicles, and exchanges it
+     * with the best call of any other vehicle, each taking the other's positions.
+     * 
+     * @param solution Solution to apply operator on
+     * @param iteration Current iteration
+     * @param rng Random number generator Engine
+     * @return Neighbour solution
+     */
+    Solution apply(Solution* solution, int iteration, Xoshiro256& rng);
+};
+
+class CrossExchange : public Operator {
+    public:
+    /**
+     * @brief Cross-exchange is an operator which
+     * randomly selects two of our vehicles, and exchanges the best pair of route ends,
+     * cut where neither vehicle carries anything.
+     * 
+     * @param solution Solution to apply operator on
+     * @param iteration Current iteration
+     * @param rng Random number generator Engine
+     * @return Neighbour solution
+     */
+    Solution apply(Solution* solution, int iteration, Xoshiro256& rng);
+};
+
+class LocalSearch : public Operator {
+    public:
+    /**
+     * @brief Local search is an operator which
+     * improves the solution to a local optimum of relocate, pair swap and Or-opt moves.
+     * 
+     * @param solution Solution to apply operator on
+     * @param iteration Current iteration
+     * @param rng Random number generator Engine
+     * @return Neighbour solution
+     */
+    Solution apply(Solution* solution, int iteration, Xoshiro256& rng);
+};
+
+class PartitionRepair : public Operator {
+    public:
+    /**
+     * @brief Create a Partition Repair operator.
+     * 
+     * @param partitions Number of vehicle partitions to destroy and repair concurrently
+     */
+    PartitionRepair(int partitions);
+
+    /**
+     * @brief Partition repair is an operator which
+     * clusters the vehicles around random seed vehicles by the travel time between their home nodes, and gives every call to the
+     * partition of its vehicle. Each partition then removes random calls of its own and greedily inserts them into its own vehicles,
+     * concurrently on separate copies, after which all partitions which did not get worse are merged into the neighbour.
+     * 
+     * @param solution Solution to apply operator on
+     * @param iteration Current iteration
+     * @param rng Random number generator Engine
+     * @return Neighbour solution
+     */
+    Solution apply(Solution* solution, int iteration, Xoshiro256& rng);
+
+    private:
+    int partitions;
 };
 
 /**
@@ -275,4 +612,11 @@ class RandomBeamInsert : public Operator {
  * @param rng Random number generator engine
  * @return Sampled integer 
  */
-int boundedUniformSample(Solution* solution, int iteration, std::default_random_engine& rng);
\ No newline at end of file
+int boundedUniformSample(Solution* solution, int iteration, Xoshiro256& rng);
+
+/**
+ * @brief Get the number of calls last sampled by boundedUniformSample on this thread, and clear it.
+ * 
+ * @return Sampled number of calls, 0 if none was sampled since last taken
+ */
+int takeSampledCalls();
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cmath>
 #include <string>
 #include <fstream>
 #include <iostream>
@@ -17,6 +18,9 @@ class Parser {
      */
     static Problem parseProblem(std::string path);
 
+    // Whether parsed problems use granular insertion neighbourhoods, instead of enumerating every insertion position exactly
+    static bool granularNeighbourhoods;
+
     private:
     // This is a static class, prevent class creation
     Parser();
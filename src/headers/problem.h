@@ -1,8 +1,11 @@
 #pragma once
 
+#include <memory>
 #include <unordered_set>
 #include <vector>
 
+#include "routecache.h"
+
 struct {
     int time;
     int cost;
@@ -18,6 +21,11 @@ struct {
     double relatedness;
 } typedef Similarity;
 
+struct {
+    bool feasible;
+    int cost;
+} typedef EmptyRoute;
+
 struct {
     int homeNode;
     int startTime;
@@ -26,6 +34,10 @@ struct {
     std::unordered_set<int> possibleCallsSet;
     std::vector<std::vector<TimeCost>> routeTimeCost;
     std::vector<std::pair<TimeCost, TimeCost>> callTimeCost;
+    int triangleSlack;
+    bool capacityUnconstrained;
+    std::vector<EmptyRoute> emptyRoutes;
+    int equivalenceClass;
 } typedef Vehicle;
 
 struct {
@@ -38,6 +50,9 @@ struct {
     std::vector<int> possibleVehicles;
     std::unordered_set<int> possibleVehiclesSet;
     std::vector<Similarity> similarities;
+    std::vector<bool> relatedCalls;
+    int originRadius;
+    int destinationRadius;
 } typedef Call;
 
 class Problem {
@@ -45,6 +60,13 @@ class Problem {
     int noNodes;
     int noVehicles;
     int noCalls;
+    int granularity;
     std::vector<Vehicle> vehicles;
     std::vector<Call> calls;
+
+    // Evaluated routes, shared by all solutions and threads working on the problem
+    std::shared_ptr<RouteCache> routeCache;
+
+    // Best routes per call set, shared by all solutions and threads working on the problem
+    std::shared_ptr<SequenceCache> sequenceCache;
 };
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include <climits>
+#include <algorithm>
+
+#include "arena.h"
+#include "solution.h"
+
+struct {
+    int cost;
+    int time;
+    int picked;
+    int delivered;
+    int last;
+    int parent;
+} typedef SequenceLabel;
+
+// Largest number of calls in a route which is re-sequenced exactly
+const int RESEQUENCE_MAX_CALLS = 6;
+
+/**
+ * @brief Find the cheapest feasible order of a set of calls in a vehicle, by dynamic programming over which
+ * calls are picked up and delivered and the last stop. Only labels (cost, time) not dominated by another of
+ * the same state are kept, which makes it exact under time windows.
+ *
+ * @param problem Problem the calls belong to
+ * @param vehicle Vehicle to drive the route
+ * @param calls Calls to sequence, each once
+ * @param route Vector to write the best route into
+ * @return Cost of the best route, INT_MAX if there is no feasible order
+ */
+int sequenceCalls(Problem* problem, Vehicle& vehicle, std::vector<int>& calls, std::vector<int>& route);
+
+/**
+ * @brief Re-sequence the route of a vehicle optimally, if it holds at most RESEQUENCE_MAX_CALLS calls.
+ * Results are cached per vehicle class and call set, so repeated call sets cost only a lookup.
+ *
+ * @param vehicleIndex Vehicle to re-sequence the route of
+ * @param solution Solution to modify
+ * @return true if the route was improved,
+ * @return false otherwise
+ */
+bool resequenceRoute(int vehicleIndex, Solution* solution);
+
+/**
+ * @brief Re-sequence every small enough route of a solution optimally.
+ *
+ * @param solution Solution to modify
+ * @return Number of improved routes
+ */
+int resequenceRoutes(Solution* solution);
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+class Xoshiro256 {
+    public:
+    typedef std::uint64_t result_type;
+
+    /**
+     * @brief Create a xoshiro256** generator, filling its state from the seed with splitmix64.
+     *
+     * @param seed Seed of the generator
+     */
+    Xoshiro256(std::uint64_t seed = 1);
+
+    /**
+     * @brief Generate the next number of the stream.
+     *
+     * @return Uniformly distributed 64-bit number
+     */
+    result_type operator()();
+
+    /**
+     * @brief Advance the generator by 2^128 numbers, as if that many were generated.
+     */
+    void jump();
+
+    /**
+     * @brief Advance the generator by 2^192 numbers, as if that many were generated.
+     */
+    void longJump();
+
+    /**
+     * @brief Split off an independent stream for another thread, island or neighbour.
+     * The new generator continues from the current state, while this one jumps 2^128 numbers ahead,
+     * so neither ever reaches numbers of the other in practice.
+     *
+     * @return Generator of the split off stream
+     */
+    Xoshiro256 split();
+
+    static constexpr result_type min() {
+        return 0;
+    }
+
+    static constexpr result_type max() {
+        return UINT64_MAX;
+    }
+
+    private:
+    std::uint64_t state[4];
+
+    /**
+     * @brief Advance the generator by a power of two given as a polynomial.
+     *
+     * @param polynomial Jump polynomial
+     */
+    void jump(const std::uint64_t (&polynomial)[4]);
+};
+
+class AliasTable {
+    public:
+    /**
+     * @brief Create an empty alias table, which has to be built before sampling.
+     */
+    AliasTable() = default;
+
+    /**
+     * @brief Build the table of the given weights in linear time (Vose's method).
+     *
+     * @param weights Non-negative weights, not all zero
+     */
+    void build(const std::vector<double>& weights);
+
+    /**
+     * @brief Sample an index with probability proportional to its weight, in constant time.
+     *
+     * @param rng Random number generator
+     * @return Sampled index
+     */
+    int sample(Xoshiro256& rng);
+
+    private:
+    std::vector<double> probabilities;
+    std::vector<int> aliases;
+};
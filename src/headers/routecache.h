@@ -0,0 +1,169 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <unordered_map>
+
+struct {
+    bool feasible;
+    std::pair<int, bool> failure;
+    int cost;
+    int endTime;
+} typedef RouteEvaluation;
+
+struct {
+    unsigned long long key;
+    int vehicleClass;
+    std::vector<int> route;
+    RouteEvaluation evaluation;
+} typedef RouteCacheEntry;
+
+struct {
+    std::mutex mutex;
+    std::list<RouteCacheEntry> entries;
+    std::unordered_map<unsigned long long, std::list<RouteCacheEntry>::iterator> index;
+} typedef RouteCacheShard;
+
+// Number of routes remembered by the route cache of every problem
+const int ROUTE_CACHE_CAPACITY = 1 << 15;
+
+// Number of independently locked parts of the route cache
+const int ROUTE_CACHE_SHARDS = 16;
+
+class RouteCache {
+    public:
+    /**
+     * @brief Construct an empty route cache, evicting the least recently used routes when full.
+     *
+     * @param capacity Number of routes to remember
+     * @param shards Number of independently locked parts, such that threads rarely wait on each other
+     */
+    RouteCache(int capacity, int shards);
+
+    /**
+     * @brief Hash a route of a given vehicle class.
+     *
+     * @param vehicleClass Equivalence class of the vehicle driving the route
+     * @param route Route to hash
+     * @return Key of the route
+     */
+    static unsigned long long key(int vehicleClass, std::vector<int>& route);
+
+    /**
+     * @brief Look up the evaluation of a route.
+     * Found routes are compared in full, so colliding keys are never mistaken for each other.
+     *
+     * @param key Key of the route, as given by RouteCache::key
+     * @param vehicleClass Equivalence class of the vehicle driving the route
+     * @param route Route to look up
+     * @param evaluation Evaluation to write the found one into
+     * @return true if the route was found,
+     * @return false otherwise
+     */
+    bool lookup(unsigned long long key, int vehicleClass, std::vector<int>& route, RouteEvaluation& evaluation);
+
+    /**
+     * @brief Store the evaluation of a route, evicting the least recently used route of its shard if full.
+     *
+     * @param key Key of the route, as given by RouteCache::key
+     * @param vehicleClass Equivalence class of the vehicle driving the route
+     * @param route Route to store
+     * @param evaluation Evaluation of the route
+     */
+    void store(unsigned long long key, int vehicleClass, std::vector<int>& route, RouteEvaluation& evaluation);
+
+    /**
+     * @brief Get the number of routes found by lookups.
+     *
+     * @return Number of hits
+     */
+    long long hits();
+
+    /**
+     * @brief Get the number of routes not found by lookups.
+     *
+     * @return Number of misses
+     */
+    long long misses();
+
+    /**
+     * @brief Get the fraction of lookups which found their route.
+     *
+     * @return Hit rate in [0, 1]
+     */
+    double hitRate();
+
+    private:
+    int shardCapacity;
+    int noShards;
+    std::unique_ptr<RouteCacheShard[]> shards;
+    std::atomic<long long> hitCount, missCount;
+};
+
+struct {
+    int vehicleClass;
+    std::vector<int> calls;
+    std::vector<int> route;
+    int cost;
+} typedef SequenceCacheEntry;
+
+// Number of call sets remembered by the sequence cache of every problem
+const int SEQUENCE_CACHE_CAPACITY = 1 << 14;
+
+class SequenceCache {
+    public:
+    /**
+     * @brief Construct an empty cache of the best route for each set of calls, per vehicle class.
+     * When full, it is cleared entirely, as call sets seen long ago rarely come back.
+     *
+     * @param capacity Number of call sets to remember
+     */
+    SequenceCache(int capacity);
+
+    /**
+     * @brief Look up the best route for a set of calls.
+     *
+     * @param vehicleClass Equivalence class of the vehicle driving the route
+     * @param calls Sorted calls of the route, each once
+     * @param route Route to write the best found one into
+     * @param cost Cost to write the cost of the best route into
+     * @return true if the call set was found,
+     * @return false otherwise
+     */
+    bool lookup(int vehicleClass, std::vector<int>& calls, std::vector<int>& route, int& cost);
+
+    /**
+     * @brief Store the best route for a set of calls.
+     *
+     * @param vehicleClass Equivalence class of the vehicle driving the route
+     * @param calls Sorted calls of the route, each once
+     * @param route Best route for the calls
+     * @param cost Cost of the best route
+     */
+    void store(int vehicleClass, std::vector<int>& calls, std::vector<int>& route, int cost);
+
+    /**
+     * @brief Get the number of call sets found by lookups.
+     *
+     * @return Number of hits
+     */
+    long long hits();
+
+    /**
+     * @brief Get the number of call sets not found by lookups.
+     *
+     * @return Number of misses
+     */
+    long long misses();
+
+    private:
+    int capacity;
+    std::mutex mutex;
+    std::unordered_map<unsigned long long, SequenceCacheEntry> entries;
+    std::atomic<long long> hitCount, missCount;
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <random>
+#include <memory>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+#include "testcase.h"
+#include "threadpool.h"
+
+struct {
+    std::string instance;
+    std::string algorithm;
+    unsigned int seed;
+    double time;
+    int target;
+} typedef Job;
+
+class Scheduler {
+    public:
+    /**
+     * @brief Read the jobs to run from the command line.
+     * Every argument 'instance:algorithm:seed:minutes[:target]' is a job, '--jobs <file>' reads a job 'instance algorithm seed minutes [target]'
+     * from each line of a file (skipping empty lines and lines starting with '#'), and '--experiments <n>' sets the experiments per job.
+     * A job stops early once its best objective reaches its target, if given. Every job stops early after '--stagnation <iterations>'
+     * without a new best solution, or once its best objective improves less than '--improvement <fraction> <iterations>' over that many iterations.
+     * Island and tempering jobs check these after every epoch, counting the iterations of a single island or replica.
+     * Insertions are enumerated exactly, unless '--granular' restricts them to granular neighbourhoods.
+     * Algorithms are 'final', 'batch' (final with a batch of neighbours per core), 'island' (an island per core)
+     * 'bandit' (final choosing operators by a contextual bandit instead) and 'tempering' (parallel tempering with a replica per core).
+     *
+     * @param argc Number of arguments
+     * @param argv Arguments
+     * @param experiments Number of experiments per job, set if given
+     * @param criteria Termination criteria of every job, set if given
+     * @return Jobs in the order given
+     */
+    static std::vector<Job> parseArguments(int argc, char const *argv[], int& experiments, TerminationCriteria& criteria);
+
+    /**
+     * @brief Run every experiment of every job as a separate task on the shared work-stealing thread pool, along with the tasks within them.
+     * Experiments are stopped once converged, and the batches of the others grow to the cores freed up.
+     * Parallel loops within an experiment run on the workers left idle, or else on the experiment's own thread.
+     *
+     * @param jobs Jobs to run
+     * @param experiments Number of experiments per job
+     * @param criteria Termination criteria of every job, along with its own target
+     * @return Information about each job, in the order they were given
+     */
+    static std::vector<AlgorithmInformation> run(std::vector<Job>& jobs, int experiments, TerminationCriteria criteria);
+
+    /**
+     * @brief Create the adaptive neighbourhood operator used by every algorithm, crediting its operators by wall time in searches bounded by time.
+     *
+     * @return Adaptive operator, owned by the caller
+     */
+    static Operator* createOperator();
+
+    /**
+     * @brief Create the neighbourhood operators every algorithm chooses from.
+     *
+     * @return Operators to choose from
+     */
+    static std::vector<Operator*> createOperators();
+
+    private:
+    // This is a static class, prevent class creation
+    Scheduler();
+
+    /**
+     * @brief Parse a single job.
+     *
+     * @param description Instance, algorithm, seed, minutes and optionally the target, split by the separator
+     * @param separator Character between the fields
+     * @param job Job to write into
+     * @return true if the job is valid,
+     * @return false otherwise
+     */
+    static bool parseJob(std::string description, char separator, Job& job);
+
+    /**
+     * @brief Run a single experiment of a job, seeded from the job's seed and the experiment.
+     *
+     * @param job Job to run
+     * @param experiment Index of the experiment
+     * @param budget Controller sharing the cores among the experiments
+     * @param criteria Termination criteria, along with the target of the job
+     * @return Information about the experiment
+     */
+    static AlgorithmInformation runExperiment(Job& job, int experiment, BudgetController& budget, TerminationCriteria criteria);
+
+    /**
+     * @brief Merge the information of several experiments of the same job.
+     *
+     * @param experiments Information about each experiment
+     * @return Information about all of them, averaged
+     */
+    static AlgorithmInformation merge(std::vector<AlgorithmInformation>& experiments);
+};
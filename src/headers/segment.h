@@ -0,0 +1,103 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "arena.h"
+#include "solution.h"
+
+struct {
+    bool empty;
+    int firstNode;
+    int lastNode;
+    int duration;
+    int timeWarp;
+    int earliest;
+    int latest;
+    int cost;
+    int load;
+    int peakLoad;
+} typedef Segment;
+
+/**
+ * @brief Get the empty segment, the identity of concatenation.
+ *
+ * @return Empty segment
+ */
+Segment emptySegment();
+
+/**
+ * @brief Get the segment of a vehicle's start, leaving its home node at its start time.
+ *
+ * @param vehicle Vehicle to start
+ * @return Start segment
+ */
+Segment startSegment(Vehicle& vehicle);
+
+/**
+ * @brief Get the segment of a single stop, picking up or delivering a call.
+ *
+ * @param vehicle Vehicle visiting the stop
+ * @param problem Problem the call belongs to
+ * @param callIndex Call to pickup or deliver
+ * @param pickup true if picking up, false if delivering
+ * @return Stop segment
+ */
+Segment stopSegment(Vehicle& vehicle, Problem* problem, int callIndex, bool pickup);
+
+/**
+ * @brief Concatenate two segments in constant time, travelling from the last stop of the first to the first stop of the second.
+ * Keeps the duration, time warp (lateness), earliest and latest start, cost, load change and peak load of the result.
+ *
+ * @param vehicle Vehicle driving both segments
+ * @param a First segment
+ * @param b Second segment
+ * @return Concatenated segment
+ */
+Segment concatenate(Vehicle& vehicle, Segment a, Segment b);
+
+/**
+ * @brief Check if a segment, starting without any load, can be driven by a vehicle.
+ *
+ * @param vehicle Vehicle driving the segment
+ * @param segment Segment to check
+ * @return true if no time window is violated and the capacity is never exceeded,
+ * @return false otherwise
+ */
+bool isSegmentFeasible(Vehicle& vehicle, Segment& segment);
+
+class RouteSegments {
+    public:
+    /**
+     * @brief Summarize every subsequence of a route, as driven by a given vehicle.
+     * Takes quadratic time, after which any route built from these subsequences is evaluated in constant time.
+     *
+     * @param vehicleIndex Vehicle driving the route (which may be another vehicle than the route belongs to)
+     * @param route Route to summarize, which need not be part of the solution
+     * @param solution Solution giving the problem
+     */
+    RouteSegments(int vehicleIndex, std::vector<int>& route, Solution* solution);
+
+    /**
+     * @brief Get the segment of stops [begin, end).
+     *
+     * @param begin First stop
+     * @param end One past the last stop
+     * @return Segment of the stops
+     */
+    Segment& between(int begin, int end);
+
+    /**
+     * @brief Get the segment of the vehicle's start followed by stops [0, end).
+     *
+     * @param end One past the last stop
+     * @return Segment of the start and the stops
+     */
+    Segment& prefix(int end);
+
+    int stops;
+
+    private:
+    ScratchVector<Segment> table;
+    ScratchVector<Segment> prefixes;
+};
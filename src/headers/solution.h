@@ -2,15 +2,19 @@
 
 #include <set>
 #include <queue>
+#include <atomic>
 #include <memory>
 #include <vector>
 #include <random>
 #include <cassert>
+#include <climits>
 #include <algorithm>
 #include <functional>
 #include <unordered_set>
 
 #include "problem.h"
+#include "arena.h"
+#include "rng.h"
 
 struct {
     int vehicle;
@@ -18,6 +22,19 @@ struct {
     bool removed;
 } typedef CallDetails;
 
+struct {
+    long long version;
+    std::vector<int> times;
+    std::vector<int> capacities;
+    std::vector<int> nodes;
+    std::vector<int> legTimes;
+    std::vector<int> legCosts;
+    std::vector<int> slack;
+    std::vector<int> waiting;
+} typedef RouteProfile;
+
+class InsertionCache;
+
 class Solution {
     public:
 
@@ -38,7 +55,7 @@ class Solution {
      * @param rng Random number generator Engine
      * @return Random solution for the given problem 
      */
-    static Solution randomSolution(Problem* problem, std::default_random_engine& rng);
+    static Solution randomSolution(Problem* problem, Xoshiro256& rng);
 
     /**
      * @brief Strictly add call to vehicle.
@@ -71,6 +88,17 @@ class Solution {
      */
     void move(int vehicleIndex, int callIndex, std::pair<int, int> indices);
 
+    /**
+     * @brief Replace the route of a vehicle, for example by another order of the same calls.
+     * Calls in the new route are moved into the vehicle, calls only in the old route have to be placed elsewhere.
+     * 
+     * @note Updates cost and feasibility for you!
+     * 
+     * @param vehicleIndex Vehicle to replace the route of (not outsource)
+     * @param route New route
+     */
+    void replaceRoute(int vehicleIndex, std::vector<int>& route);
+
     /**
      * @brief Outsource a given call. Everything handled automatically.
      * 
@@ -132,6 +160,21 @@ class Solution {
      */
     std::pair<std::vector<int>, std::vector<int>> getDetails(int vehicleIndex, int timeConstraint);
 
+    /**
+     * @brief Get the cached time and capacity profile of a given vehicle.
+     * The profile is recomputed only if the vehicle's route changed since it was last requested,
+     * and shared with copies of the solution until their route changes, so copying does not duplicate it.
+     * 
+     * @note Times are departure times after each stop, so they are non-decreasing along the route.
+     * Legs and slack are indexed by stop, where legs are the travel into each stop and slack is how much
+     * the arrival at each stop can be delayed without violating any later time window.
+     * Both have an extra trailing entry for the end of the route (an empty leg and unlimited slack).
+     * 
+     * @param vehicleIndex Given vehicle
+     * @return Profile of departure times and capacities (starting with the vehicle's start), nodes, legs, slack and waiting times
+     */
+    RouteProfile& getProfile(int vehicleIndex);
+
     /**
      * @brief Returns a copy of the current solution.
      * 
@@ -152,6 +195,15 @@ class Solution {
      * Call whenever solution is modified.
      */
     void invalidateCache();
+
+    /**
+     * @brief Check if calls may be inserted into a vehicle.
+     * 
+     * @param vehicleIndex Given vehicle (not outsource)
+     * @return true if the solution owns the vehicle, which it does for all vehicles unless restricted,
+     * @return false otherwise
+     */
+    bool ownsVehicle(int vehicleIndex);
     
     int outsourceVehicle;
 
@@ -160,6 +212,16 @@ class Solution {
     std::vector<CallDetails> callDetails;
 
     std::vector<int> costs;
+
+    // Profile of each route, valid if computed for its current version, and shared with copies
+    std::vector<std::shared_ptr<RouteProfile>> profiles;
+
+    // Version of each route, renewed on every change, and the insertion cache shared with all copies
+    std::vector<long long> versions;
+    std::shared_ptr<InsertionCache> insertionCache;
+
+    // Vehicles the heuristics may insert into, all of them if empty
+    std::vector<bool> ownedVehicles;
     
     std::pair<bool, bool> feasibilityCache;
     std::pair<bool, int> costCache;
@@ -172,4 +234,33 @@ class Solution {
     private:
     // Only allow static instance creation, unless created from given vector (above)
     Solution(Problem* problem);
+
+    // Last route version handed out, unique over all solutions
+    static std::atomic<long long> lastVersion;
+
+    /**
+     * @brief Checks if the route of a single vehicle is feasible.
+     * 
+     * @tparam TrackCapacity Whether the capacity has to be checked, false for capacity-unconstrained vehicles
+     * @param vehicleIndex Vehicle to check the route of
+     * @param endTime Time the route ends at, set if feasible
+     * @return true if feasible,
+     * @return false if infeasible
+     */
+    template<bool TrackCapacity>
+    bool isRouteFeasible(int vehicleIndex, int& endTime);
+
+    /**
+     * @brief Calculates feasibility of the solution, given that ONLY a specific (non-outsource) vehicleIndex changed.
+     * 
+     * @tparam TrackCapacity Whether the capacity has to be tracked, false for capacity-unconstrained vehicles
+     * @param vehicleIndex Specific vehicle which has changed
+     * @param startIndex Greedy start of feasibility calculation
+     * @param startTime Current time at greedy start of feasibility calculation
+     * @param startCapacity Current capacity at greedy start of feasibility calculation
+     * @param endTime Time the route ends at, set if feasible
+     * @return Pair (index of failure, true if due to capacity else false)
+     */
+    template<bool TrackCapacity>
+    std::pair<int, bool> updateRouteFeasibility(int vehicleIndex, int startIndex, int startTime, int startCapacity, int& endTime);
 };
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <algorithm>
+
+#include "timer.h"
+
+// Iterations between two reads of the clock, by default
+const int CLOCK_INTERVAL = 10;
+
+struct {
+    int target;
+    double minimumImprovement;
+    int window;
+    int maxStagnation;
+    int clockInterval;
+} typedef TerminationCriteria;
+
+// Only stop at the deadline
+const TerminationCriteria DEADLINE_ONLY = {0, 0.0, 0, 0, CLOCK_INTERVAL};
+
+class Termination {
+    public:
+    /**
+     * @brief Prepare the termination check of a search, which stops at the deadline or as soon as any of the given criteria holds:
+     * the best cost reached the target (if above 0), the best cost improved less than the minimum improvement (relative) over the last
+     * window of iterations (if both above 0), or the search went more than the maximum stagnation iterations without a new best (if above 0).
+     *
+     * @param criteria Criteria to stop on
+     * @param deadline Time of the search in seconds
+     * @param timer Timer of the search, started
+     */
+    Termination(TerminationCriteria criteria, double deadline, Timer* timer);
+
+    /**
+     * @brief Check whether the search should stop before an iteration.
+     * The criteria are evaluated in constant time, and the clock is only read every clock interval iterations.
+     * Iterations may advance by more than one between checks, as between the epochs of parallel searches.
+     *
+     * @param iteration Iteration about to run
+     * @param bestCost Cost of the best solution so far
+     * @param lastImprovement Iteration the best solution was last improved
+     * @return true if the search should stop,
+     * @return false otherwise
+     */
+    bool done(int iteration, int bestCost, int lastImprovement);
+
+    /**
+     * @brief Get the seconds since the search started, as last read from the clock.
+     *
+     * @return Time in seconds
+     */
+    double elapsed();
+
+    /**
+     * @brief Get the criterion the search stopped on.
+     *
+     * @return Description of the criterion, empty if the search did not stop yet
+     */
+    std::string reason();
+
+    private:
+    TerminationCriteria criteria;
+    double deadline;
+    Timer* timer;
+
+    double lastElapsed = 0;
+    int clockRead = -1;
+    int windowStart = -1;
+    int windowCost = 0;
+    std::string stoppedOn;
+};
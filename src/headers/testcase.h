@@ -3,12 +3,22 @@
 #include <cmath>
 #include <string>
 #include <random>
+#include <numeric>
 #include <functional>
+#include <unordered_set>
 
 #include "parser.h"
 #include "timer.h"
+#include "arena.h"
 #include "debug.h"
 #include "operator.h"
+#include "resequence.h"
+#include "localsearch.h"
+#include "threadpool.h"
+#include "island.h"
+#include "budget.h"
+#include "termination.h"
+#include "heapcounter.h"
 
 struct EpisodeInformation {
     Solution solution;
@@ -17,8 +27,20 @@ struct EpisodeInformation {
     int iterfound;
     double timefound;
     int totalIterations;
+
+    // Heap allocations per iteration after warm-up, -1 if the warm-up was never finished
+    double heapAllocations;
+    long long insertionCacheHits;
+    long long insertionCacheMisses;
+    std::string stoppedOn;
 } typedef EpisodeInformation;
 
+// Iterations after which the scratch arena and buffers are expected to have grown to their final size, and heap allocations are counted
+const int SCRATCH_WARMUP_ITERATIONS = 1000;
+
+// Iterations without a new best solution after which the search escapes
+const int ESCAPE_ITERATIONS = 7500;
+
 struct AlgorithmInformation {
     std::string instance;
     std::string algorithm;
@@ -27,6 +49,7 @@ struct AlgorithmInformation {
     double improvement;
     double averageTime;
     std::vector<EpisodeInformation> episodes;
+    double routeCacheHitRate;
 } typedef AlgorithmInformation;
 
 class InstanceRunner {
@@ -41,7 +64,7 @@ class InstanceRunner {
      * @param rng Random number generator engine
      * @param title Output title in loading bar and result txt
      */
-    static void testAlgorithm(std::function<void(Operator*, std::string, int, int, std::default_random_engine&, std::string)> algorithm, Operator* neighbourOperator, int experiments, int iterations, std::default_random_engine& rng, std::string title);
+    static void testAlgorithm(std::function<void(Operator*, std::string, int, int, Xoshiro256&, std::string)> algorithm, Operator* neighbourOperator, int experiments, int iterations, Xoshiro256& rng, std::string title);
 
     /**
      * @brief Assignment 2. 
@@ -54,7 +77,7 @@ class InstanceRunner {
      * @param rng Random number generator (for randomness)
      * @param title Output title in loading bar and result txt
      */
-    static void blindRandomSearch(Operator* neighbourOperator, std::string instance, int experiments, int iterations, std::default_random_engine& rng, std::string title);
+    static void blindRandomSearch(Operator* neighbourOperator, std::string instance, int experiments, int iterations, Xoshiro256& rng, std::string title);
 
     /**
      * @brief Assignment 3.
@@ -67,7 +90,7 @@ class InstanceRunner {
      * @param rng Random number generator (for randomness)
      * @param title Output title in loading bar and result txt
      */
-    static void localSearch(Operator* neighbourOperator, std::string instance, int experiments, int iterations, std::default_random_engine& rng, std::string title);
+    static void localSearch(Operator* neighbourOperator, std::string instance, int experiments, int iterations, Xoshiro256& rng, std::string title);
 
     /**
      * @brief Assignment 3 and 4.
@@ -80,7 +103,7 @@ class InstanceRunner {
      * @param rng Random number generator (for randomness)
      * @param title Output title in loading bar and result txt
      */
-    static void simulatedAnnealing(Operator* neighbourOperator, std::string instance, int experiments, int iterations, std::default_random_engine& rng, std::string title);
+    static void simulatedAnnealing(Operator* neighbourOperator, std::string instance, int experiments, int iterations, Xoshiro256& rng, std::string title);
 
     /**
      * @brief Assignment 5.
@@ -93,7 +116,7 @@ class InstanceRunner {
      * @param rng Random number generator (for randomness)
      * @param title Output title in loading bar and result txt
      */
-    static void generalAdaptiveMetaheuristic(Operator* neighbourOperator, std::string instance, int experiments, int iterations, std::default_random_engine& rng, std::string title);
+    static void generalAdaptiveMetaheuristic(Operator* neighbourOperator, std::string instance, int experiments, int iterations, Xoshiro256& rng, std::string title);
 
     /**
      * @brief Final exam.
@@ -106,12 +129,83 @@ class InstanceRunner {
      * @param time Alloted time to run each experiment (in minutes)
      * @param rng Random number generator (for randomness)
      * @param title Output title in loading bar and result txt
+     * @param batchSize Neighbours generated concurrently per iteration, of which the best one is considered for acceptance,
+     * at most as many as the cores the budget controller shares with the search if given
+     * @param budget Controller to report progress to, which stops the search once converged, nullptr to always run until the deadline
+     * @param criteria Criteria to stop before the deadline on, and how often to read the clock
+     * 
+     * @return Return information about the given algorithm.
+     */
+    static AlgorithmInformation finalAdaptiveMetaheuristic(Operator* neighbourOperator, std::string instance, int experiments, double time, Xoshiro256& rng, std::string title, int batchSize = 1, BudgetController* budget = nullptr, TerminationCriteria criteria = DEADLINE_ONLY);
+
+    /**
+     * @brief Final exam, in parallel.
+     * Runs independent searches of the final adaptive metaheuristic (islands) on the same test case, each with its own operator
+     * and random number stream. Islands run epochs of MIGRATION_INTERVAL iterations on the shared thread pool, after which
+     * each one continues from its predecessor's best solution in a ring, if that is better than its own incumbent.
+     * 
+     * @note Given a number of iterations, the result only depends on the random number generator and the number of islands.
+     * 
+     * @param createOperator Function creating the neighbourhood operator of an island, owned and freed by the run
+     * @param instance Name of the test case instance to run
+     * @param experiments Number of experiments to run
+     * @param time Alloted time to run each experiment (in minutes), used if no iterations are given
+     * @param islands Number of islands
+     * @param rng Random number generator, from which every island splits off its own stream
+     * @param iterations Iterations per island and experiment, 0 to run until the time is up
+     * @param title Output title in loading bar and result txt
+     * @param budget Controller to report progress to after every epoch, which stops the search once converged, nullptr to always run until the end
+     * @param criteria Criteria to stop before the end on, checked after every epoch on the best solution of all of them, counting iterations per search
      * 
      * @return Return information about the given algorithm.
      */
-    static AlgorithmInformation finalAdaptiveMetaheuristic(Operator* neighbourOperator, std::string instance, int experiments, double time, std::default_random_engine& rng, std::string title);
+    static AlgorithmInformation islandAdaptiveMetaheuristic(std::function<Operator*()> createOperator, std::string instance, int experiments, double time, int islands, Xoshiro256& rng, int iterations, std::string title, BudgetController* budget = nullptr, TerminationCriteria criteria = DEADLINE_ONLY);
+
+    /**
+     * @brief Parallel tempering (replica exchange).
+     * Runs simulated annealing chains (replicas) at fixed temperatures on the same test case, each with its own operator and random number stream.
+     * The temperatures range geometrically from accepting an average worse neighbour with probability HOTTEST_ACCEPTANCE down to COLDEST_ACCEPTANCE,
+     * calibrated on a warm-up epoch. Replicas run epochs of EXCHANGE_INTERVAL iterations on the shared thread pool, after which neighbouring
+     * temperatures swap their solutions with the Metropolis criterion, alternating between even and odd pairs.
+     * 
+     * @note Given a number of iterations, the result only depends on the random number generator and the number of replicas.
+     * 
+     * @param createOperator Function creating the neighbourhood operator of a replica, owned and freed by the run
+     * @param instance Name of the test case instance to run
+     * @param experiments Number of experiments to run
+     * @param time Alloted time to run each experiment (in minutes), used if no iterations are given
+     * @param replicas Number of replicas, at least two
+     * @param rng Random number generator, deciding the exchanges and from which every replica splits off its own stream
+     * @param iterations Iterations per replica and experiment, 0 to run until the time is up
+     * @param title Output title in loading bar and result txt
+     * @param budget Controller to report progress to after every epoch, which stops the search once converged, nullptr to always run until the end
+     * @param criteria Criteria to stop before the end on, checked after every epoch on the best solution of all of them, counting iterations per search
+     * 
+     * @return Return information about the given algorithm.
+     */
+    static AlgorithmInformation parallelTempering(std::function<Operator*()> createOperator, std::string instance, int experiments, double time, int replicas, Xoshiro256& rng, int iterations, std::string title, BudgetController* budget = nullptr, TerminationCriteria criteria = DEADLINE_ONLY);
 
     private:
     // This is a static class, prevent class creation
     InstanceRunner();
+
+    /**
+     * @brief Run a single iteration of the final adaptive metaheuristic, escaping first if long without a new best solution.
+     * 
+     * @param state Search to advance
+     * @param remaining Fraction of the budget left, which narrows the acceptance threshold
+     * @param elapsed Seconds since the experiment started
+     * @param dMultiplier Scale of the acceptance threshold
+     * @param printEscapes Whether to print escapes and new best solutions
+     */
+    static void adaptiveIteration(SearchState& state, double remaining, double elapsed, double dMultiplier, bool printEscapes);
+
+    /**
+     * @brief Run a single iteration of simulated annealing at a fixed temperature, intensifying around new best solutions.
+     * 
+     * @param state Replica to advance
+     * @param temperature Temperature of the replica
+     * @param elapsed Seconds since the experiment started
+     */
+    static void temperingIteration(SearchState& state, double temperature, double elapsed);
 };
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+
+#include "heapcounter.h"
+
+class ThreadPool {
+    public:
+    /**
+     * @brief Construct a work-stealing thread pool.
+     * Every worker owns a task queue, and idle workers steal from the queues of others.
+     *
+     * @param threads Number of worker threads (0 runs everything on the calling thread)
+     * @param pinned Whether to pin worker i to core i+1, leaving the first core to the thread creating the pool
+     */
+    ThreadPool(int threads, bool pinned = false);
+
+    /**
+     * @brief Finish all queued tasks and join every worker.
+     */
+    ~ThreadPool();
+
+    /**
+     * @brief Get the pool shared by the whole process.
+     * It is sized such that the workers, together with a waiting caller, fill up every core, and each worker is pinned to its own core.
+     *
+     * @return Shared thread pool
+     */
+    static ThreadPool& shared();
+
+    /**
+     * @brief Queue a task for execution.
+     * Tasks submitted from a worker are pushed onto that worker's own queue.
+     *
+     * @param task Task to execute
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * @brief Execute task(i) for every i in [begin, end) and wait for all of them to finish.
+     * Queued helpers and the calling thread claim the indices of this loop until none are left.
+     *
+     * @note The calling thread only ever runs indices of its own loop, so it never gets stuck in unrelated tasks,
+     * and blocks once all of them are claimed. Nested calls never deadlock, as every claimed index is being run.
+     *
+     * @param begin First index
+     * @param end One past the last index
+     * @param task Task to execute per index
+     */
+    void parallelFor(int begin, int end, std::function<void(int)> task);
+
+    /**
+     * @brief Get the number of worker threads.
+     *
+     * @return Number of workers
+     */
+    int size();
+
+    private:
+    struct Worker {
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+    };
+
+    struct Group {
+        std::function<void(int)>* task;
+        std::atomic<int> next;
+        std::atomic<int> remaining;
+        std::atomic<long long> allocations;
+        int end;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    std::mutex sleepMutex;
+    std::condition_variable wakeup;
+    std::atomic<int> pending{0};
+    std::atomic<int> nextWorker{0};
+    bool stopping = false;
+    bool pinned;
+
+    /**
+     * @brief Run a single queued task, if any exists.
+     * Pops from the back of the preferred queue first, then steals from the front of the others.
+     *
+     * @param preferred Queue to look in first
+     * @return true if a task was run,
+     * @return false if every queue was empty
+     */
+    bool runPending(int preferred);
+
+    /**
+     * @brief Claim and run indices of a parallel loop, until every index is claimed.
+     *
+     * @param group Parallel loop to run indices of
+     * @param helper Whether the thread is helping another, counting its heap allocations towards the loop
+     */
+    static void runGroup(Group& group, bool helper);
+
+    /**
+     * @brief Pin the calling thread to a single core, where supported (Linux only).
+     *
+     * @param core Core to run on
+     */
+    static void pin(int core);
+
+    /**
+     * @brief Main loop of a worker thread.
+     *
+     * @param index Index of the worker
+     */
+    void work(int index);
+};
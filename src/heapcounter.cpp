@@ -0,0 +1,33 @@
+#include <new>
+#include <cstdlib>
+
+#include "heapcounter.h"
+
+// Allocations of the current thread, trivially initialized such that operator new may use it at any time
+thread_local long long threadAllocations = 0;
+
+long long HeapCounter::allocations() {
+    return threadAllocations;
+}
+
+void HeapCounter::credit(long long allocations) {
+    threadAllocations += allocations;
+}
+
+// Replace the global allocation functions, counting every allocation (the array, nothrow and sized variants forward to these)
+void* operator new(std::size_t bytes) {
+    threadAllocations++;
+    void* pointer = std::malloc(bytes == 0 ? 1 : bytes);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
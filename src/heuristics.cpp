@@ -1,9 +1,9 @@
 #include "heuristics.h"
 #include "debug.h"
 
-std::vector<int> removeSimilar(int callsToRemove, Solution* solution, std::default_random_engine& rng) {
+ScratchVector<int> removeSimilar(int callsToRemove, Solution* solution, Xoshiro256& rng) {
     // Initialize a vector to hold all removed calls
-    std::vector<int> callIndices;
+    ScratchVector<int> callIndices;
     callIndices.reserve(callsToRemove);
 
     // Initially remove a random call
@@ -22,18 +22,18 @@ std::vector<int> removeSimilar(int callsToRemove, Solution* solution, std::defau
     return callIndices;
 }
 
-std::vector<int> removeCostly(int callsToRemove, Solution* solution, std::default_random_engine& rng) {
+ScratchVector<int> removeCostly(int callsToRemove, Solution* solution, Xoshiro256& rng) {
     // Create a copy of the current solution
     Solution current = solution->copy();
 
     // Store every removed costly call
-    std::vector<int> callIndices;
+    ScratchVector<int> callIndices;
     callIndices.reserve(callsToRemove);
 
     // Iteratively sample every call
     for (int i = 0; i < callsToRemove; i++) {
         // First calculate the cost of each call
-        std::vector<std::pair<int, int>> costlyCalls;
+        ScratchVector<std::pair<int, int>> costlyCalls;
         costlyCalls.reserve(solution->problem->noCalls);
         for (int callIndex = 1; callIndex <= solution->problem->noCalls; callIndex++) {
             // Skip removed calls
@@ -64,21 +64,21 @@ std::vector<int> removeCostly(int callsToRemove, Solution* solution, std::defaul
     return callIndices;
 }
 
-std::vector<int> removeRandom(int callsToRemove, Solution* solution, std::default_random_engine& rng) {
+ScratchVector<int> removeRandom(int callsToRemove, Solution* solution, Xoshiro256& rng) {
     // Initialize a vector to hold all removed calls
-    std::vector<int> callIndices;
+    ScratchVector<int> callIndices;
     callIndices.reserve(callsToRemove);
 
     // Randomly sample all calls to remove 
     // "https://stackoverflow.com/a/3724708"
-    std::unordered_set<int> sampledCalls;
     int total = solution->problem->noCalls+1;
+    ScratchVector<char> sampledCalls(total, false);
     for (int i = total - callsToRemove; i < total; i++) {
         int callIndex = std::uniform_int_distribution<int>(1, i)(rng); 
-        if (sampledCalls.find(callIndex) != sampledCalls.end()) {
+        if (sampledCalls[callIndex]) {
             callIndex = i;
         }
-        sampledCalls.insert(callIndex);
+        sampledCalls[callIndex] = true;
 
         // Remove the call and add them to vector
         solution->remove(callIndex);
@@ -89,13 +89,11 @@ std::vector<int> removeRandom(int callsToRemove, Solution* solution, std::defaul
     return callIndices;
 }
 
-void insertGreedy(std::set<int>& callIndices, Solution* solution) {
-    // Initially calculate all feasible insertion positions for all the calls
-    std::map<int, std::vector<std::vector<std::pair<int, CallDetails>>>> feasibleInsertions;
-    for (int callIndex : callIndices) {
-        // Find all feasible insertions for callIndex sorted from best-to-worst
-        feasibleInsertions.insert(std::make_pair(callIndex, calculateFeasibleInsertions(callIndex, solution, true)));
-    }
+void insertGreedy(ScratchVector<int>& callIndices, Solution* solution) {
+    // Initially calculate the feasible insertion positions for all the calls, skipping vehicles which can't
+    // hold their best, but remembering the lowest lower bound of those skipped
+    ScratchVector<int> prunedBounds(solution->problem->noCalls, INT_MAX);
+    ScratchVector<VehicleInsertions> feasibleInsertions = calculateAllFeasibleInsertions(callIndices, solution, true, 1, &prunedBounds);
 
     // Move each call into its best possible position
     while (!callIndices.empty()) {
@@ -103,7 +101,7 @@ void insertGreedy(std::set<int>& callIndices, Solution* solution) {
         CallDetails bestInsertion;
 
         for (int callIndex : callIndices) {
-            std::vector<std::vector<std::pair<int, CallDetails>>>& feasibleCallInsertions = feasibleInsertions.find(callIndex)->second;
+            VehicleInsertions& feasibleCallInsertions = feasibleInsertions[callIndex-1];
 
             for (int vehicleIndex = 1; vehicleIndex <= solution->outsourceVehicle; vehicleIndex++) {
                 if (feasibleCallInsertions[vehicleIndex-1].empty()) {
@@ -124,24 +122,25 @@ void insertGreedy(std::set<int>& callIndices, Solution* solution) {
 
         // Move the current best call into its best position and remove it from the set
         solution->add(bestInsertion.vehicle, bestCall, bestInsertion.indices);
-        callIndices.erase(bestCall);
+        callIndices.erase(std::lower_bound(callIndices.begin(), callIndices.end(), bestCall));
 
         assert(deltaCost >= 0);
 
         // If the call was inserted into a vehicle (which is not outsource),
         // and there still exist calls to be inserted, update all other's feasible insertion for that vehicle
         if (bestInsertion.vehicle != solution->outsourceVehicle) {
+            handOverEmptyInsertions(feasibleInsertions, callIndices, bestInsertion.vehicle, solution);
             for (int callIndex : callIndices) {
-                if (feasibleInsertions.find(callIndex)->second[bestInsertion.vehicle-1].empty()) {
+                if (feasibleInsertions[callIndex-1][bestInsertion.vehicle-1].empty()) {
                     continue;
                 }
-                feasibleInsertions.find(callIndex)->second[bestInsertion.vehicle-1] = greedyFeasibleInsertions(bestInsertion.vehicle, callIndex, solution, true);
+                feasibleInsertions[callIndex-1][bestInsertion.vehicle-1] = greedyFeasibleInsertions(bestInsertion.vehicle, callIndex, solution, true, 1);
             }
         }
 
         // And update the cost of the other insertions to correctly include cost of the next call
         for (int callIndex : callIndices) {
-            std::vector<std::vector<std::pair<int, CallDetails>>>& feasibleCallInsertions = feasibleInsertions.find(callIndex)->second;
+            VehicleInsertions& feasibleCallInsertions = feasibleInsertions[callIndex-1];
 
             for (int vehicleIndex = 1; vehicleIndex <= solution->outsourceVehicle; vehicleIndex++) {
                 if (vehicleIndex == bestInsertion.vehicle && vehicleIndex != solution->outsourceVehicle) {
@@ -153,16 +152,35 @@ void insertGreedy(std::set<int>& callIndices, Solution* solution) {
                 }
             }
         }
+
+        // Skipped vehicles' bounds move along with the cost, except for the vehicle inserted into
+        for (int callIndex : callIndices) {
+            int& prunedBound = prunedBounds[callIndex-1];
+            if (prunedBound != INT_MAX) {
+                prunedBound += deltaCost;
+            }
+            if (bestInsertion.vehicle != solution->outsourceVehicle && feasibleInsertions[callIndex-1][bestInsertion.vehicle-1].empty()) {
+                prunedBound = std::min(prunedBound, solution->getCost() + insertionLowerBound(bestInsertion.vehicle, callIndex, solution));
+            }
+
+            // If a skipped vehicle might now hold the best insertion, recalculate the call's insertions
+            int callBestCost = INT_MAX;
+            for (Insertions& insertions : feasibleInsertions[callIndex-1]) {
+                if (!insertions.empty()) {
+                    callBestCost = std::min(callBestCost, insertions[0].first);
+                }
+            }
+            if (callBestCost >= prunedBound) {
+                feasibleInsertions[callIndex-1] = calculateFeasibleInsertions(callIndex, solution, true, 1, &prunedBound);
+            }
+        }
     }
 }
 
-void insertRegret(std::set<int>& callIndices, Solution* solution, int k) {
+void insertRegret(ScratchVector<int>& callIndices, Solution* solution, int k) {
    // Initially calculate all feasible insertion positions for all the calls
-    std::map<int, std::vector<std::vector<std::pair<int, CallDetails>>>> feasibleInsertions;
-    for (int callIndex : callIndices) {
-        // Find all feasible insertions for callIndex sorted from best-to-worst
-        feasibleInsertions.insert(std::make_pair(callIndex, calculateFeasibleInsertions(callIndex, solution, true)));
-    }
+    // Only the k+1 cheapest insertions of each call are needed for its regret
+    ScratchVector<VehicleInsertions> feasibleInsertions = calculateAllFeasibleInsertions(callIndices, solution, true, k+1);
 
     // Move each call into its best possible position
     while (!callIndices.empty()) {
@@ -170,10 +188,10 @@ void insertRegret(std::set<int>& callIndices, Solution* solution, int k) {
         CallDetails bestInsertion;
 
         for (int callIndex : callIndices) {
-            std::vector<std::vector<std::pair<int, CallDetails>>>& feasibleCallInsertions = feasibleInsertions.find(callIndex)->second;
+            VehicleInsertions& feasibleCallInsertions = feasibleInsertions[callIndex-1];
 
             // First add all to 1-dimensional sorted vector to easily compare insertions over different vehicles
-            std::vector<std::pair<int, CallDetails>> feasibleCallInsertionsUnwrapped;
+            Insertions feasibleCallInsertionsUnwrapped;
             for (auto && inner : feasibleCallInsertions) {
                 feasibleCallInsertionsUnwrapped.insert(feasibleCallInsertionsUnwrapped.end(), inner.begin(), inner.end());
             }
@@ -199,18 +217,19 @@ void insertRegret(std::set<int>& callIndices, Solution* solution, int k) {
 
         // Move the call with the highest regret into its best position and remove it from the set
         solution->add(bestInsertion.vehicle, bestCall, bestInsertion.indices);
-        callIndices.erase(bestCall);
+        callIndices.erase(std::lower_bound(callIndices.begin(), callIndices.end(), bestCall));
 
         // If the call was inserted into a vehicle (which is not outsource), update all other's feasible insertion for that vehicle
         if (bestInsertion.vehicle != solution->outsourceVehicle) {
+            handOverEmptyInsertions(feasibleInsertions, callIndices, bestInsertion.vehicle, solution);
             for (int callIndex : callIndices) {
-                feasibleInsertions.find(callIndex)->second[bestInsertion.vehicle-1] = greedyFeasibleInsertions(bestInsertion.vehicle, callIndex, solution, true);
+                feasibleInsertions[callIndex-1][bestInsertion.vehicle-1] = greedyFeasibleInsertions(bestInsertion.vehicle, callIndex, solution, true, k+1);
             }
         }
 
         // And update the cost of the other insertions to correctly include cost of the next call
         for (int callIndex : callIndices) {
-            std::vector<std::vector<std::pair<int, CallDetails>>>& feasibleCallInsertions = feasibleInsertions.find(callIndex)->second;
+            VehicleInsertions& feasibleCallInsertions = feasibleInsertions[callIndex-1];
             for (int vehicleIndex = 1; vehicleIndex <= solution->outsourceVehicle; vehicleIndex++) {
                 if (vehicleIndex == bestInsertion.vehicle && vehicleIndex != solution->outsourceVehicle) {
                     continue;
@@ -224,102 +243,101 @@ void insertRegret(std::set<int>& callIndices, Solution* solution, int k) {
     }
 }
 
-void insertBeam(std::set<int>& callIndices, Solution* solution, int width) {
-    // Keep track of the beam-width number of best solutions, together with its set of not yet inserted calls
-    std::vector<std::pair<Solution, std::pair<std::queue<std::pair<int, CallDetails>>, std::set<int>>>> beam;
-    beam.push_back(std::make_pair(solution->copy(), std::make_pair(std::queue<std::pair<int, CallDetails>>(), callIndices)));
+void insertBeam(ScratchVector<int>& callIndices, Solution* solution, int width) {
+    // Keep track of the beam-width number of best solutions, together with its steps taken and sorted not yet inserted calls
+    ScratchVector<std::pair<Solution, std::pair<Insertions, ScratchVector<int>>>> beam;
+    beam.push_back(std::make_pair(solution->copy(), std::make_pair(Insertions(), callIndices)));
 
-    for (int i = 0; i < callIndices.size(); i++) {
-        // Store the current most promising solutions
-        std::vector<std::pair<int, std::pair<Solution, std::pair<std::queue<std::pair<int, CallDetails>>, std::set<int>>>>> temporary;
-        temporary.reserve(beam.size() * width);
-
-        for (auto && [current, info] : beam) {
-            std::queue<std::pair<int, CallDetails>>& steps = info.first;
-            std::set<int>& calls = info.second;
-
-            // Initially calculate all feasible insertion positions for all the calls
-            std::vector<std::pair<int, std::pair<int, CallDetails>>> bestInsertions;
-            bestInsertions.reserve(calls.size() * width);
-
-            for (int callIndex : calls) {
-                // Find all feasible insertions for callIndex sorted from best-to-worst, unwrap them
-                std::vector<std::pair<int, CallDetails>> feasibleCallInsertionsUnwrapped;
-                for (auto && inner : calculateFeasibleInsertions(callIndex, &current, true)) {
-                    feasibleCallInsertionsUnwrapped.insert(feasibleCallInsertionsUnwrapped.end(), inner.begin(), inner.end());
-                }
-                std::sort(feasibleCallInsertionsUnwrapped.begin(), feasibleCallInsertionsUnwrapped.end(), [](const std::pair<int, CallDetails>& a, const std::pair<int, CallDetails>& b) {
-                    return a.first < b.first;
-                });
+    // Order candidates by cost, breaking ties by expansion order to stay deterministic under threading
+    auto compareCandidates = [](const BeamCandidate& a, const BeamCandidate& b) {
+        return a.cost < b.cost || (a.cost == b.cost && a.order < b.order);
+    };
 
-                // and remember the (up to) beam-width best ones
-                for (int j = 0; j < std::min(width, (int)feasibleCallInsertionsUnwrapped.size()); j++) {
-                    bestInsertions.push_back(std::make_pair(callIndex, feasibleCallInsertionsUnwrapped[j]));
-                }
+    for (int i = 0; i < callIndices.size(); i++) {
+        // Every (beam state, call) pair is an independent expansion
+        ScratchVector<std::pair<int, int>> expansions;
+        for (int state = 0; state < beam.size(); state++) {
+            for (int callIndex : beam[state].second.second) {
+                expansions.push_back(std::make_pair(state, callIndex));
             }
+        }
 
-            // Then sort this to get only the best of the best
-            std::sort(bestInsertions.begin(), bestInsertions.end(), [](const std::pair<int, std::pair<int, CallDetails>>& a, const std::pair<int, std::pair<int, CallDetails>>& b) {
-                return a.second.first < b.second.first;
-            });
+        // Reserve every expansion's result here, as tasks may run on other threads with their own arenas
+        ScratchVector<ScratchVector<BeamCandidate>> expanded(expansions.size());
+        for (ScratchVector<BeamCandidate>& candidates : expanded) {
+            candidates.reserve(width);
+        }
 
-            // Store the beam-width best ones in temporary solution storage
-            for (int j = 0; j < std::min(width, (int)bestInsertions.size()); j++) {
-                int callIndex = bestInsertions[j].first;
-                CallDetails insertion = bestInsertions[j].second.second;
+        // Expand them concurrently, each keeping its (up to) beam-width best insertions, locally sorted
+        ThreadPool::shared().parallelFor(0, expansions.size(), [&](int e) {
+            ArenaScope scope;
+            auto [state, callIndex] = expansions[e];
 
-                Solution copy = current.copy();
-                copy.add(insertion.vehicle, callIndex, insertion.indices);
+            // Evaluation temporarily modifies the solution, so work on a private copy
+            Solution current = beam[state].first.copy();
 
-                std::queue<std::pair<int, CallDetails>> stepsCopy = steps;
-                stepsCopy.push(std::make_pair(callIndex, insertion));
-                std::set<int> callsCopy(calls.begin(), calls.end());
-                callsCopy.erase(callIndex);
-                temporary.push_back(std::make_pair(copy.getCost(), std::make_pair(copy, std::make_pair(stepsCopy, callsCopy))));
+            // Find all feasible insertions for callIndex, unwrap them
+            ScratchVector<BeamCandidate> candidates;
+            for (auto && inner : calculateFeasibleInsertions(callIndex, &current, true, width)) {
+                for (std::pair<int, CallDetails>& insertion : inner) {
+                    candidates.push_back({insertion.first, state, callIndex, insertion.second, ((long long)e << 32) + (long long)candidates.size()});
+                }
             }
-        }
 
-        // Then sort all temporary solutions by cost and pick the beam-width best ones
-        std::sort(temporary.begin(), temporary.end(), [](const std::pair<int, std::pair<Solution, std::pair<std::queue<std::pair<int, CallDetails>>, std::set<int>>>>& a, const std::pair<int, std::pair<Solution, std::pair<std::queue<std::pair<int, CallDetails>>, std::set<int>>>>& b) {
-            return a.first < b.first;
+            // and remember the (up to) beam-width best ones
+            int keep = std::min(width, (int)candidates.size());
+            std::partial_sort(candidates.begin(), candidates.begin() + keep, candidates.end(), compareCandidates);
+            expanded[e].assign(candidates.begin(), candidates.begin() + keep);
         });
 
-        beam.clear();
-        for (int j = 0; beam.size() < std::min(width, (int)temporary.size()); j++) {
-            beam.push_back(temporary[j].second);
+        // Then merge the local selections to get only the beam-width best of the best
+        ScratchVector<BeamCandidate> bestInsertions;
+        for (ScratchVector<BeamCandidate>& candidates : expanded) {
+            bestInsertions.insert(bestInsertions.end(), candidates.begin(), candidates.end());
+        }
+        int keep = std::min(width, (int)bestInsertions.size());
+        std::partial_sort(bestInsertions.begin(), bestInsertions.begin() + keep, bestInsertions.end(), compareCandidates);
+
+        // Only now build the solutions which made it into the next beam
+        ScratchVector<std::pair<Solution, std::pair<Insertions, ScratchVector<int>>>> next;
+        next.reserve(keep);
+        for (int j = 0; j < keep; j++) {
+            BeamCandidate& candidate = bestInsertions[j];
+            auto && [current, info] = beam[candidate.state];
+
+            Solution copy = current.copy();
+            copy.add(candidate.insertion.vehicle, candidate.callIndex, candidate.insertion.indices);
+
+            Insertions stepsCopy = info.first;
+            stepsCopy.push_back(std::make_pair(candidate.callIndex, candidate.insertion));
+            ScratchVector<int> callsCopy = info.second;
+            callsCopy.erase(std::lower_bound(callsCopy.begin(), callsCopy.end(), candidate.callIndex));
+            next.push_back(std::make_pair(copy, std::make_pair(stepsCopy, callsCopy)));
         }
+        beam = std::move(next);
     }
 
-    // Now we have the best solution found through beam search
-    std::queue<std::pair<int, CallDetails>> steps = beam[0].second.first;
-
-    // TODO: Insert all the calls into solution given this best solution
-    while (!steps.empty()) {
-        auto && [callIndex, insertion] = steps.front();
-        steps.pop();
+    // Now we have the best solution found through beam search, so take the same steps in the given solution
+    for (auto && [callIndex, insertion] : beam[0].second.first) {
         solution->add(insertion.vehicle, callIndex, insertion.indices);
     }
 }
 
-void insertRandom(std::set<int>& callIndices, Solution* solution, std::default_random_engine& rng) {
+void insertRandom(ScratchVector<int>& callIndices, Solution* solution, Xoshiro256& rng) {
     // Initially calculate all feasible insertion positions for all the calls
-    std::map<int, std::vector<std::vector<std::pair<int, CallDetails>>>> feasibleInsertions;
-    for (int callIndex : callIndices) {
-        // Find all feasible insertions for callIndex sorted from best-to-worst
-        feasibleInsertions.insert(std::make_pair(callIndex, calculateFeasibleInsertions(callIndex, solution, false)));
-    }
+    ScratchVector<VehicleInsertions> feasibleInsertions = calculateAllFeasibleInsertions(callIndices, solution, false);
 
     // Move each call into its best possible position
     while (!callIndices.empty()) {
         // Select a random call
-        std::vector<int> out;
+        ScratchVector<int> out;
         std::sample(callIndices.begin(), callIndices.end(), std::back_inserter(out), 1, rng);
         int callIndex = out[0];
 
-        std::vector<std::vector<std::pair<int, CallDetails>>>& feasibleCallInsertions = feasibleInsertions.find(callIndex)->second;
+        VehicleInsertions& feasibleCallInsertions = feasibleInsertions[callIndex-1];
 
             // Add all to 1-dimensional vector to easily sample random insertions over different vehicles
-        std::vector<std::pair<int, CallDetails>> feasibleCallInsertionsUnwrapped;
+        Insertions feasibleCallInsertionsUnwrapped;
         for (auto && inner : feasibleCallInsertions) {
             feasibleCallInsertionsUnwrapped.insert(feasibleCallInsertionsUnwrapped.end(), inner.begin(), inner.end());
         }
@@ -329,37 +347,90 @@ void insertRandom(std::set<int>& callIndices, Solution* solution, std::default_r
 
         // Move the call with the highest regret into its best position and remove it from the set
         solution->add(insertion.vehicle, callIndex, insertion.indices);
-        callIndices.erase(callIndex);
+        callIndices.erase(std::lower_bound(callIndices.begin(), callIndices.end(), callIndex));
 
         // If the call was inserted into a vehicle (which is not outsource), update all other's feasible insertion for that vehicle
         if (insertion.vehicle != solution->outsourceVehicle) {
+            handOverEmptyInsertions(feasibleInsertions, callIndices, insertion.vehicle, solution);
             for (int callIndex : callIndices) {
-                feasibleInsertions.find(callIndex)->second[insertion.vehicle-1] = greedyFeasibleInsertions(insertion.vehicle, callIndex, solution, false);
+                feasibleInsertions[callIndex-1][insertion.vehicle-1] = greedyFeasibleInsertions(insertion.vehicle, callIndex, solution, false);
             }
         }
     }
 }
 
-std::vector<std::vector<std::pair<int, CallDetails>>> calculateFeasibleInsertions(int callIndex, Solution* solution, bool sort) {
+ScratchVector<VehicleInsertions> calculateAllFeasibleInsertions(ScratchVector<int>& callIndices, Solution* solution, bool sort, int limit, ScratchVector<int>* prunedBounds) {
+    // Keep a flat table indexed by call, only filled for the given calls
+    ScratchVector<VehicleInsertions> feasibleInsertions(solution->problem->noCalls);
+    for (int callIndex : callIndices) {
+        int* prunedBound = (prunedBounds == nullptr) ? nullptr : &(*prunedBounds)[callIndex-1];
+        feasibleInsertions[callIndex-1] = calculateFeasibleInsertions(callIndex, solution, sort, limit, prunedBound);
+    }
+    return feasibleInsertions;
+}
+
+VehicleInsertions calculateFeasibleInsertions(int callIndex, Solution* solution, bool sort, int limit, int* prunedBound) {
     // Get the call and its feasible vehicles
     Call& call = solution->problem->calls[callIndex-1];
     std::vector<int>& possibleVehicles = call.possibleVehicles;
 
     // Initialize a vector for storing feasible insertions for each vehicle
-    std::vector<std::vector<std::pair<int, CallDetails>>> feasibleInsertions;
-    feasibleInsertions.resize(solution->problem->noVehicles);
-
-    // Check all insertions within every possible vehicle
+    VehicleInsertions feasibleInsertions;
+    feasibleInsertions.resize(solution->problem->noVehicles+1);
+
+    // Find every possible vehicle large enough to ever carry the call, with a lower bound of the cost after insertion.
+    // Empty vehicles of the same equivalence class are interchangeable, so only the first of them is evaluated
+    int baseCost = solution->getCost();
+    ScratchVector<std::pair<int, int>> vehicleBounds;
+    ScratchVector<char> emptyClassSeen(solution->problem->noVehicles+1);
     for (int vehicleIndex : possibleVehicles) {
-        feasibleInsertions[vehicleIndex-1] = greedyFeasibleInsertions(vehicleIndex, callIndex, solution, sort);
+        Vehicle& vehicle = solution->problem->vehicles[vehicleIndex-1];
+        if (vehicle.capacity < call.size || !solution->ownsVehicle(vehicleIndex)) {
+            continue;
+        }
+        if (solution->representation[vehicleIndex-1].empty()) {
+            if (emptyClassSeen[vehicle.equivalenceClass]) {
+                continue;
+            }
+            emptyClassSeen[vehicle.equivalenceClass] = true;
+        }
+        vehicleBounds.push_back(std::make_pair(baseCost + insertionLowerBound(vehicleIndex, callIndex, solution), vehicleIndex));
+    }
+
+    if (prunedBound == nullptr) {
+        // Check all insertions within every vehicle
+        for (auto && [bound, vehicleIndex] : vehicleBounds) {
+            feasibleInsertions[vehicleIndex-1] = greedyFeasibleInsertions(vehicleIndex, callIndex, solution, sort, limit);
+        }
+    } else {
+        // Only the best insertion matters, so check vehicles from lowest to highest bound, starting with
+        // outsourcing as the best so far, and stop at the first vehicle which can't improve on it
+        int bestCost = baseCost + call.costOfNotTransporting;
+        *prunedBound = INT_MAX;
+
+        std::sort(vehicleBounds.begin(), vehicleBounds.end());
+        for (auto && [bound, vehicleIndex] : vehicleBounds) {
+            if (bound > bestCost) {
+                *prunedBound = std::min(*prunedBound, bound);
+                break;
+            }
+
+            // Insertions more expensive than the best so far aren't needed either
+            feasibleInsertions[vehicleIndex-1] = greedyFeasibleInsertions(vehicleIndex, callIndex, solution, sort, limit, bestCost);
+            if (feasibleInsertions[vehicleIndex-1].empty()) {
+                // Without any, the vehicle's best insertion is infeasible or more expensive than the best so far
+                *prunedBound = std::min(*prunedBound, std::max(bound, bestCost+1));
+            }
+            for (std::pair<int, CallDetails>& insertion : feasibleInsertions[vehicleIndex-1]) {
+                bestCost = std::min(bestCost, insertion.first);
+            }
+        }
     }
 
     // Aswell as checking outsource
     solution->outsource(callIndex);
     solution->updateFeasibility(solution->outsourceVehicle);
-    std::vector<std::pair<int, CallDetails>> outsourceInsertion;
-    outsourceInsertion.push_back(std::make_pair(solution->getCost(), solution->callDetails[callIndex-1]));
-    feasibleInsertions.push_back(outsourceInsertion);
+    feasibleInsertions.back().push_back(std::make_pair(solution->getCost(), solution->callDetails[callIndex-1]));
 
     // Remove call again before returning
     solution->remove(callIndex);
@@ -367,68 +438,283 @@ std::vector<std::vector<std::pair<int, CallDetails>>> calculateFeasibleInsertion
     return feasibleInsertions;
 }
 
-std::vector<std::pair<int, CallDetails>> greedyFeasibleInsertions(int vehicleIndex, int callIndex, Solution* solution, bool sort) {
+int insertionLowerBound(int vehicleIndex, int callIndex, Solution* solution) {
+    Vehicle& vehicle = solution->problem->vehicles[vehicleIndex-1];
+    Call& call = solution->problem->calls[callIndex-1];
+
+    // An empty route becomes exactly home -> origin -> destination
+    if (solution->representation[vehicleIndex-1].empty()) {
+        return vehicle.emptyRoutes[callIndex-1].cost;
+    }
+
+    // The call is always picked up and delivered
+    int bound = vehicle.callTimeCost[callIndex-1].first.cost + vehicle.callTimeCost[callIndex-1].second.cost;
+    std::vector<std::vector<TimeCost>>& routeTimeCost = vehicle.routeTimeCost;
+
+    // In any other route, each stop is inserted into a leg of the route (or appended), so its detour
+    // is at least the cheapest of those
+    RouteProfile& profile = solution->getProfile(vehicleIndex);
+    int originDetour = INT_MAX, destinationDetour = INT_MAX;
+    int previousNode = vehicle.homeNode;
+    for (int node : profile.nodes) {
+        originDetour = std::min(originDetour, routeTimeCost[previousNode-1][call.originNode-1].cost + routeTimeCost[call.originNode-1][node-1].cost - routeTimeCost[previousNode-1][node-1].cost);
+        destinationDetour = std::min(destinationDetour, routeTimeCost[previousNode-1][call.destinationNode-1].cost + routeTimeCost[call.destinationNode-1][node-1].cost - routeTimeCost[previousNode-1][node-1].cost);
+        previousNode = node;
+    }
+    originDetour = std::min(originDetour, routeTimeCost[previousNode-1][call.originNode-1].cost);
+    destinationDetour = std::min(destinationDetour, routeTimeCost[previousNode-1][call.destinationNode-1].cost);
+
+    // When both are inserted into the same leg, the pair's detour is still at least the larger one,
+    // up to how much the costs violate the triangle inequality
+    return bound + std::min(originDetour + destinationDetour, std::max(originDetour, destinationDetour) - vehicle.triangleSlack);
+}
+
+void handOverEmptyInsertions(ScratchVector<VehicleInsertions>& feasibleInsertions, ScratchVector<int>& callIndices, int vehicleIndex, Solution* solution) {
+    // Only a vehicle holding nothing but the inserted call was empty before
+    if (solution->representation[vehicleIndex-1].size() != 2) {
+        return;
+    }
+
+    // Find the next empty vehicle of the same equivalence class, if any
+    int equivalenceClass = solution->problem->vehicles[vehicleIndex-1].equivalenceClass;
+    int equivalentVehicle = 0;
+    for (int otherIndex = equivalenceClass; otherIndex <= solution->problem->noVehicles; otherIndex++) {
+        if (otherIndex != vehicleIndex && solution->problem->vehicles[otherIndex-1].equivalenceClass == equivalenceClass && solution->representation[otherIndex-1].empty() && solution->ownsVehicle(otherIndex)) {
+            equivalentVehicle = otherIndex;
+            break;
+        }
+    }
+    if (equivalentVehicle == 0) {
+        return;
+    }
+
+    // Its insertions are exactly those into the vehicle while it was empty
+    for (int callIndex : callIndices) {
+        Insertions& insertions = feasibleInsertions[callIndex-1][equivalentVehicle-1];
+        insertions = feasibleInsertions[callIndex-1][vehicleIndex-1];
+        for (std::pair<int, CallDetails>& insertion : insertions) {
+            insertion.second.vehicle = equivalentVehicle;
+        }
+    }
+}
+
+Insertions greedyFeasibleInsertions(int vehicleIndex, int callIndex, Solution* solution, bool sort, int limit, int cutoff) {
     // Get the call and its feasible vehicles
     Call& call = solution->problem->calls[callIndex-1];
     std::unordered_set<int>& possibleVehiclesSet = call.possibleVehiclesSet;
 
     // Initialize a vector for storing feasible insertions for this vehicle
-    std::vector<std::pair<int, CallDetails>> feasibleInsertions;
+    Insertions feasibleInsertions;
 
-    // If vehicle is not a feasible vehicle, return early
-    if (possibleVehiclesSet.find(vehicleIndex) == possibleVehiclesSet.end()) {
+    // If vehicle is not a feasible vehicle (or not one the solution may insert into), return early
+    if (possibleVehiclesSet.find(vehicleIndex) == possibleVehiclesSet.end() || !solution->ownsVehicle(vehicleIndex)) {
         return feasibleInsertions;
     }
 
-    // Store initial vehicle details
-    std::pair<std::vector<int>, std::vector<int>> details = solution->getDetails(vehicleIndex, call.pickupWindow.end);
-    std::vector<int>& times = details.first, capacities = details.second;
+    // Inserting into an empty vehicle has only one outcome, which is precomputed
+    if (solution->representation[vehicleIndex-1].empty()) {
+        EmptyRoute& emptyRoute = solution->problem->vehicles[vehicleIndex-1].emptyRoutes[callIndex-1];
+        int cost = solution->getCost() + emptyRoute.cost;
+        if (emptyRoute.feasible && cost <= cutoff) {
+            feasibleInsertions.push_back(std::make_pair(cost, CallDetails{vehicleIndex, std::make_pair(0, 1), false}));
+        }
+        return feasibleInsertions;
+    }
 
-    // Loop over every possible insertion point
-    for (int pointer1 = 0; pointer1 < solution->representation[vehicleIndex-1].size()+1; pointer1++) {
-        for (int pointer2 = pointer1+1; pointer2 < solution->representation[vehicleIndex-1].size()+2; pointer2++) {
+    // Reuse the best insertions found earlier, if the route hasn't changed since
+    long long version = solution->versions[vehicleIndex-1];
+    if (limit > 0 && solution->insertionCache->lookup(vehicleIndex, callIndex, version, limit, cutoff, solution->getCost(), feasibleInsertions)) {
+        return feasibleInsertions;
+    }
 
-            // Insert the call at the current position
-            solution->add(vehicleIndex, callIndex, std::make_pair(pointer1, pointer2));
+    // Get the cached vehicle details
+    RouteProfile& profile = solution->getProfile(vehicleIndex);
+    std::vector<int>& times = profile.times, & capacities = profile.capacities;
+
+    // Binary search the last positions the vehicle still leaves from in time for pickup and delivery,
+    // as departure times never decrease along the route and insertions only delay them
+    int lastPickup = std::distance(times.begin(), std::upper_bound(times.begin(), times.end(), call.pickupWindow.end)) - 1;
+    int lastDelivery = std::distance(times.begin(), std::upper_bound(times.begin(), times.end(), call.deliveryWindow.end));
+
+    // With AVX2 and enough admissible pickup positions, evaluate them all at once, else each one inline when it is reached
+    bool batched = PICKUP_KERNEL_AVX2 && lastPickup+1 >= PICKUP_BATCH_MINIMUM;
+    thread_local PickupBatch batch;
+    if (batched) {
+        gatherPickupPositions(vehicleIndex, callIndex, lastPickup+1, solution, batch);
+        evaluatePickupPositions(batch);
+    }
 
-            // Check feasibility
-            std::pair<int, bool> feasibilityInformation = solution->updateFeasibility(vehicleIndex, pointer1, times[pointer1], capacities[pointer1]);
+    // In granular mode, mark which stops are related or near to the call's origin and destination
+    Vehicle& vehicle = solution->problem->vehicles[vehicleIndex-1];
+    std::vector<int>& route = solution->representation[vehicleIndex-1];
+    bool granular = solution->problem->granularity > 0;
+    ScratchVector<char> nearOrigin, nearDestination;
+    if (granular) {
+        nearOrigin.resize(route.size());
+        nearDestination.resize(route.size());
+        for (int i = 0; i < route.size(); i++) {
+            Call& stopCall = solution->problem->calls[route[i]-1];
+            int stopNode = (solution->callDetails[route[i]-1].indices.first == i) ? stopCall.originNode : stopCall.destinationNode;
+            bool related = call.relatedCalls[route[i]-1];
+            nearOrigin[i] = related || vehicle.routeTimeCost[stopNode-1][call.originNode-1].time <= call.originRadius;
+            nearDestination[i] = related || vehicle.routeTimeCost[stopNode-1][call.destinationNode-1].time <= call.destinationRadius;
+        }
+    }
 
-            // If it is feasible, store it
-            if (solution->isFeasible()) {
-                feasibleInsertions.push_back(std::make_pair(solution->getCost(), solution->callDetails[callIndex-1]));
+    // Enumerate every insertion point, with its cost and feasibility computed in constant time from the route's profile
+    std::vector<std::vector<TimeCost>>& routeTimeCost = vehicle.routeTimeCost;
+    int stops = route.size();
+    int baseCost = solution->getCost() + vehicle.callTimeCost[callIndex-1].first.cost + vehicle.callTimeCost[callIndex-1].second.cost;
+    int serviceTime = vehicle.callTimeCost[callIndex-1].first.time;
+    auto nodeAt = [&](int index) {
+        return (index < 0) ? vehicle.homeNode : profile.nodes[index];
+    };
+
+    ScratchVector<std::pair<int, std::pair<int, int>>> candidates;
+    auto enumerate = [&](auto trackCapacity) {
+        constexpr bool TrackCapacity = decltype(trackCapacity)::value;
+
+        for (int pointer1 = 0; pointer1 <= lastPickup; pointer1++) {
+            // In granular mode, only pickup next to the route ends or near stops
+            if (granular && pointer1 > 0 && pointer1 < stops && !nearOrigin[pointer1-1] && !nearOrigin[pointer1]) {
+                continue;
+            }
 
-            // If not, use infeasibility information to decide how we should check further positions
+            // Find the arrival at the origin, the detour of the pickup and how much it delays the next stop,
+            // as evaluatePickupPositionsScalar does for a batch
+            int arrival, toOriginCost, detour, shift, violations;
+            if (batched) {
+                arrival = batch.departures[pointer1] + batch.timeToOrigin[pointer1];
+                toOriginCost = batch.costToOrigin[pointer1];
+                detour = batch.detours[pointer1];
+                shift = batch.shifts[pointer1];
+                violations = batch.violations[pointer1];
             } else {
+                TimeCost& toOrigin = routeTimeCost[nodeAt(pointer1-1)-1][call.originNode-1];
+                TimeCost fromOrigin = (pointer1 < stops) ? routeTimeCost[call.originNode-1][nodeAt(pointer1)-1] : TimeCost{0, 0};
+                arrival = times[pointer1] + toOrigin.time;
+                toOriginCost = toOrigin.cost;
+                detour = toOrigin.cost + fromOrigin.cost - profile.legCosts[pointer1];
+                shift = std::max(std::max(arrival, call.pickupWindow.start) + serviceTime + fromOrigin.time - (times[pointer1] + profile.legTimes[pointer1]), 0);
+                violations = (arrival > call.pickupWindow.end ? PICKUP_LATE : 0) | (shift > profile.slack[pointer1] ? SLACK_EXCEEDED : 0);
+            }
+
+            // If the pickup is late, stop (as when found by the feasibility check below),
+            // and if the delay can't be absorbed by the rest of the route, skip it
+            if (violations & PICKUP_LATE) {
+                break;
+            } else if (violations & SLACK_EXCEEDED) {
+                continue;
+            }
+
+            // Keep track of the least capacity left while the call is carried, and how much the pickup delays the route
+            int capacityLeft = TrackCapacity ? capacities[pointer1] : 0;
+            int delay = shift;
+
+            for (int pointer2 = pointer1+1; pointer2 <= lastDelivery && pointer2 < stops+2; pointer2++) {
+                bool adjacent = pointer2 == pointer1+1;
+
+                // Carrying the call further can't fix exceeding the capacity
+                if constexpr (TrackCapacity) {
+                    capacityLeft = std::min(capacityLeft, capacities[pointer2-1]);
+                    if (capacityLeft < call.size) {
+                        break;
+                    }
+                }
+
+                // The delay is passed on through every stop the call is carried past, minus the waiting there
+                if (!adjacent) {
+                    delay = std::max(delay - profile.waiting[pointer2-2], 0);
+                }
 
-                // If due to capacity, check next pickup index
-                if (feasibilityInformation.second) {
-                    pointer2 = solution->representation[vehicleIndex-1].size()+2;
-                    
-                // Else if due to time window exceeded
+                // In granular mode, only deliver right after pickup, at the route end or near stops
+                if (granular && !adjacent && pointer2 < stops+1 && !nearDestination[pointer2-2] && !nearDestination[pointer2-1]) {
+                    continue;
+                }
+
+                // Travel to the destination, either straight from the origin or from the (delayed) stop before
+                int previousNode, departure, cost = baseCost;
+                if (adjacent) {
+                    previousNode = call.originNode;
+                    departure = std::max(arrival, call.pickupWindow.start) + serviceTime;
+                    cost += toOriginCost;
                 } else {
-                    // If at pickup index, break (pickup is outside pickup window)
-                    if (feasibilityInformation.first == pointer1) {
-                        pointer1 = solution->representation[vehicleIndex-1].size()+1;
-                        pointer2 = solution->representation[vehicleIndex-1].size()+2;
-                        
-                    // Else if at or before delivery index, break inner (delivery is outside delivery window or pickup makes another pickup/delivery infeasible)
-                    } else if (feasibilityInformation.first <= pointer2) {
-                        pointer2 = solution->representation[vehicleIndex-1].size()+2;
-                    } 
+                    previousNode = nodeAt(pointer2-2);
+                    departure = times[pointer2-1] + delay;
+                    cost += detour;
+                }
+                int arrival = departure + routeTimeCost[previousNode-1][call.destinationNode-1].time;
+                if (arrival > call.deliveryWindow.end) {
+                    continue;
+                }
+                cost += routeTimeCost[previousNode-1][call.destinationNode-1].cost;
+
+                // If there is a stop after the delivery, it replaces the leg to it, and the delay there has to be absorbed
+                if (pointer2-1 < stops) {
+                    int nextNode = nodeAt(pointer2-1);
+                    int legStart = adjacent ? nodeAt(pointer1-1) : previousNode;
+                    cost += routeTimeCost[call.destinationNode-1][nextNode-1].cost - routeTimeCost[legStart-1][nextNode-1].cost;
+
+                    int nextDelay = std::max(arrival, call.deliveryWindow.start) + vehicle.callTimeCost[callIndex-1].second.time + routeTimeCost[call.destinationNode-1][nextNode-1].time - (times[pointer2-1] + profile.legTimes[pointer2-1]);
+                    if (nextDelay > profile.slack[pointer2-1]) {
+                        continue;
+                    }
+                }
+
+                if (cost <= cutoff) {
+                    candidates.push_back(std::make_pair(cost, std::make_pair(pointer1, pointer2)));
                 }
             }
+        }
+    };
 
-            // Then remove the call again
-            solution->remove(callIndex);
+    // Choose once whether the capacity has to be tracked, as vehicles which can never exceed it don't need to
+    if (vehicle.capacityUnconstrained) {
+        enumerate(std::false_type());
+    } else {
+        enumerate(std::true_type());
+    }
+
+    // Confirm a single insertion point with a full simulation, storing it if feasible
+    auto check = [&](int cost, int pointer1, int pointer2) {
+        solution->add(vehicleIndex, callIndex, std::make_pair(pointer1, pointer2));
+        assert(solution->getCost() == cost);
+
+        solution->updateFeasibility(vehicleIndex, pointer1, times[pointer1], capacities[pointer1]);
+        if (solution->isFeasible()) {
+            feasibleInsertions.push_back(std::make_pair(cost, solution->callDetails[callIndex-1]));
+        }
+
+        solution->remove(callIndex);
+    };
+
+    if (limit == 0) {
+        // Every feasible insertion is needed, so check all in route order
+        for (auto && [cost, pointers] : candidates) {
+            check(cost, pointers.first, pointers.second);
+        }
+    } else {
+        // Else check from cheapest to most expensive, only until enough feasible insertions are found
+        auto cheaper = std::greater<std::pair<int, std::pair<int, int>>>();
+        std::make_heap(candidates.begin(), candidates.end(), cheaper);
+        while (!candidates.empty() && feasibleInsertions.size() < limit) {
+            std::pop_heap(candidates.begin(), candidates.end(), cheaper);
+            auto [cost, pointers] = candidates.back();
+            candidates.pop_back();
+            check(cost, pointers.first, pointers.second);
         }
     }
 
-    // Update feasibility
+    // Update feasibility, the route is unchanged so it gets back its version, for which its profile is still valid
     solution->updateFeasibility(vehicleIndex);
+    solution->versions[vehicleIndex-1] = version;
+
+    if (limit > 0) {
+        solution->insertionCache->store(vehicleIndex, callIndex, version, limit, cutoff, solution->getCost(), feasibleInsertions);
+    }
 
     // After all insertions, sort the vector by cost in ascending order and return
-    if (sort) {
+    if (sort && limit == 0) {
         std::sort(feasibleInsertions.begin(), feasibleInsertions.end(), [](const std::pair<int, CallDetails>& a, const std::pair<int, CallDetails>& b) {
             return a.first < b.first;
         });
@@ -0,0 +1,61 @@
+#include "insertioncache.h"
+
+InsertionCache::InsertionCache(Problem* problem, int shards) : hitCount(0), missCount(0) {
+    // Start without any entries, as no version is negative
+    this->noVehicles = problem->noVehicles;
+    this->noShards = std::max(1, shards);
+    this->entries.resize(problem->noCalls * problem->noVehicles, {-1, 0, 0, {}});
+    this->mutexes = std::make_unique<std::mutex[]>(this->noShards);
+}
+
+bool InsertionCache::lookup(int vehicleIndex, int callIndex, long long version, int limit, int cutoff, int baseCost, ScratchVector<std::pair<int, CallDetails>>& insertions) {
+    int relativeCutoff = (cutoff == INT_MAX) ? INT_MAX : cutoff - baseCost;
+
+    int index = (callIndex-1) * this->noVehicles + vehicleIndex-1;
+    std::lock_guard<std::mutex> lock(this->mutexes[index % this->noShards]);
+    CachedInsertions& entry = this->entries[index];
+
+    // The entry holds the cheapest insertions up to its cutoff, so it covers any request for fewer and cheaper ones
+    if (entry.version != version || limit > entry.limit || relativeCutoff > entry.cutoff) {
+        this->missCount++;
+        return false;
+    }
+    this->hitCount++;
+
+    for (std::pair<int, CallDetails>& insertion : entry.insertions) {
+        if (insertions.size() == limit || insertion.first > relativeCutoff) {
+            break;
+        }
+        insertions.push_back(std::make_pair(baseCost + insertion.first, insertion.second));
+    }
+    return true;
+}
+
+void InsertionCache::store(int vehicleIndex, int callIndex, long long version, int limit, int cutoff, int baseCost, ScratchVector<std::pair<int, CallDetails>>& insertions) {
+    int relativeCutoff = (cutoff == INT_MAX) ? INT_MAX : cutoff - baseCost;
+
+    int index = (callIndex-1) * this->noVehicles + vehicleIndex-1;
+    std::lock_guard<std::mutex> lock(this->mutexes[index % this->noShards]);
+    CachedInsertions& entry = this->entries[index];
+
+    // Keep the entry if it already covers more of the same route
+    if (entry.version == version && entry.limit >= limit && entry.cutoff >= relativeCutoff) {
+        return;
+    }
+
+    entry.version = version;
+    entry.limit = limit;
+    entry.cutoff = relativeCutoff;
+    entry.insertions.clear();
+    for (std::pair<int, CallDetails>& insertion : insertions) {
+        entry.insertions.push_back(std::make_pair(insertion.first - baseCost, insertion.second));
+    }
+}
+
+long long InsertionCache::hits() {
+    return this->hitCount;
+}
+
+long long InsertionCache::misses() {
+    return this->missCount;
+}
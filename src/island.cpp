@@ -0,0 +1,23 @@
+#include "island.h"
+
+EliteBoard::EliteBoard(int islands) {
+    this->slots.resize(islands);
+}
+
+void EliteBoard::publish(int island, Solution& solution) {
+    this->slots[island] = std::make_shared<Solution>(solution.copy());
+}
+
+std::shared_ptr<Solution> EliteBoard::read(int island) {
+    return this->slots[island];
+}
+
+std::shared_ptr<Solution> EliteBoard::best() {
+    std::shared_ptr<Solution> best;
+    for (std::shared_ptr<Solution>& slot : this->slots) {
+        if (slot && (!best || slot->getCost() < best->getCost())) {
+            best = slot;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,145 @@
+#include "kernel.h"
+
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+void gatherPickupPositions(int vehicleIndex, int callIndex, int count, Solution* solution, PickupBatch& batch) {
+    Vehicle& vehicle = solution->problem->vehicles[vehicleIndex-1];
+    Call& call = solution->problem->calls[callIndex-1];
+    RouteProfile& profile = solution->getProfile(vehicleIndex);
+
+    batch.windowStart = call.pickupWindow.start;
+    batch.windowEnd = call.pickupWindow.end;
+    batch.serviceTime = vehicle.callTimeCost[callIndex-1].first.time;
+    batch.count = count;
+
+    batch.departures.resize(count);
+    batch.timeToOrigin.resize(count);
+    batch.costToOrigin.resize(count);
+    batch.timeFromOrigin.resize(count);
+    batch.costFromOrigin.resize(count);
+    batch.legTimes.resize(count);
+    batch.legCosts.resize(count);
+    batch.slack.resize(count);
+    batch.detours.resize(count);
+    batch.shifts.resize(count);
+    batch.violations.resize(count);
+
+    int stops = profile.nodes.size();
+    for (int p = 0; p < count; p++) {
+        // The pickup is placed between the stop before p (or home) and the stop at p (if any)
+        int previousNode = (p == 0) ? vehicle.homeNode : profile.nodes[p-1];
+        TimeCost& toOrigin = vehicle.routeTimeCost[previousNode-1][call.originNode-1];
+
+        batch.departures[p] = profile.times[p];
+        batch.timeToOrigin[p] = toOrigin.time;
+        batch.costToOrigin[p] = toOrigin.cost;
+        if (p < stops) {
+            TimeCost& fromOrigin = vehicle.routeTimeCost[call.originNode-1][profile.nodes[p]-1];
+            batch.timeFromOrigin[p] = fromOrigin.time;
+            batch.costFromOrigin[p] = fromOrigin.cost;
+        } else {
+            batch.timeFromOrigin[p] = 0;
+            batch.costFromOrigin[p] = 0;
+        }
+        batch.legTimes[p] = profile.legTimes[p];
+        batch.legCosts[p] = profile.legCosts[p];
+        batch.slack[p] = profile.slack[p];
+    }
+}
+
+void evaluatePickupPositionsScalar(PickupBatch& batch, int begin, int end) {
+    for (int p = begin; p < end; p++) {
+        // Travel to origin, wait if early and service it
+        int arrival = batch.departures[p] + batch.timeToOrigin[p];
+        int departure = std::max(arrival, batch.windowStart) + batch.serviceTime;
+
+        // Compare the new arrival at the next stop with the current one
+        int delay = departure + batch.timeFromOrigin[p] - (batch.departures[p] + batch.legTimes[p]);
+        batch.shifts[p] = std::max(delay, 0);
+        batch.detours[p] = batch.costToOrigin[p] + batch.costFromOrigin[p] - batch.legCosts[p];
+
+        batch.violations[p] = (arrival > batch.windowEnd ? PICKUP_LATE : 0) | (batch.shifts[p] > batch.slack[p] ? SLACK_EXCEEDED : 0);
+    }
+}
+
+void evaluatePickupPositions(PickupBatch& batch) {
+    int p = 0;
+
+#if defined(__AVX2__)
+    // AVX2: 8 positions per instruction
+    __m256i windowStart = _mm256_set1_epi32(batch.windowStart);
+    __m256i windowEnd = _mm256_set1_epi32(batch.windowEnd);
+    __m256i serviceTime = _mm256_set1_epi32(batch.serviceTime);
+    __m256i zero = _mm256_setzero_si256();
+    __m256i lateFlag = _mm256_set1_epi32(PICKUP_LATE);
+    __m256i slackFlag = _mm256_set1_epi32(SLACK_EXCEEDED);
+
+    auto load = [](std::vector<int>& values, int p) {
+        return _mm256_loadu_si256((const __m256i*)(values.data() + p));
+    };
+
+    for (; p + 8 <= batch.count; p += 8) {
+        __m256i departures = load(batch.departures, p);
+
+        __m256i arrival = _mm256_add_epi32(departures, load(batch.timeToOrigin, p));
+        __m256i departure = _mm256_add_epi32(_mm256_max_epi32(arrival, windowStart), serviceTime);
+
+        __m256i delay = _mm256_sub_epi32(_mm256_add_epi32(departure, load(batch.timeFromOrigin, p)), _mm256_add_epi32(departures, load(batch.legTimes, p)));
+        __m256i shifts = _mm256_max_epi32(delay, zero);
+        __m256i detours = _mm256_sub_epi32(_mm256_add_epi32(load(batch.costToOrigin, p), load(batch.costFromOrigin, p)), load(batch.legCosts, p));
+
+        __m256i late = _mm256_and_si256(_mm256_cmpgt_epi32(arrival, windowEnd), lateFlag);
+        __m256i exceeded = _mm256_and_si256(_mm256_cmpgt_epi32(shifts, load(batch.slack, p)), slackFlag);
+
+        _mm256_storeu_si256((__m256i*)(batch.shifts.data() + p), shifts);
+        _mm256_storeu_si256((__m256i*)(batch.detours.data() + p), detours);
+        _mm256_storeu_si256((__m256i*)(batch.violations.data() + p), _mm256_or_si256(late, exceeded));
+    }
+
+#elif defined(__GNUC__)
+    // Portable vector extensions: 8 positions per operation, lowered to whatever the target supports.
+    // Lanes are only kept in locals, as passing them by value changes the ABI on targets without AVX
+    typedef int Lanes __attribute__((vector_size(32)));
+
+    Lanes windowStart = Lanes{} + batch.windowStart;
+    Lanes windowEnd = Lanes{} + batch.windowEnd;
+    Lanes serviceTime = Lanes{} + batch.serviceTime;
+    Lanes zero = Lanes{};
+
+    for (; p + 8 <= batch.count; p += 8) {
+        Lanes departures, timeToOrigin, costToOrigin, timeFromOrigin, costFromOrigin, legTimes, legCosts, slack;
+        std::memcpy(&departures, batch.departures.data() + p, sizeof(Lanes));
+        std::memcpy(&timeToOrigin, batch.timeToOrigin.data() + p, sizeof(Lanes));
+        std::memcpy(&costToOrigin, batch.costToOrigin.data() + p, sizeof(Lanes));
+        std::memcpy(&timeFromOrigin, batch.timeFromOrigin.data() + p, sizeof(Lanes));
+        std::memcpy(&costFromOrigin, batch.costFromOrigin.data() + p, sizeof(Lanes));
+        std::memcpy(&legTimes, batch.legTimes.data() + p, sizeof(Lanes));
+        std::memcpy(&legCosts, batch.legCosts.data() + p, sizeof(Lanes));
+        std::memcpy(&slack, batch.slack.data() + p, sizeof(Lanes));
+
+        // Maxima select per lane with the comparison masks
+        Lanes arrival = departures + timeToOrigin;
+        Lanes early = arrival < windowStart;
+        Lanes departure = ((windowStart & early) | (arrival & ~early)) + serviceTime;
+
+        Lanes delay = departure + timeFromOrigin - (departures + legTimes);
+        Lanes shifts = delay & (delay > zero);
+        Lanes detours = costToOrigin + costFromOrigin - legCosts;
+
+        Lanes late = (arrival > windowEnd) & PICKUP_LATE;
+        Lanes exceeded = (shifts > slack) & SLACK_EXCEEDED;
+        Lanes violations = late | exceeded;
+
+        std::memcpy(batch.shifts.data() + p, &shifts, sizeof(Lanes));
+        std::memcpy(batch.detours.data() + p, &detours, sizeof(Lanes));
+        std::memcpy(batch.violations.data() + p, &violations, sizeof(Lanes));
+    }
+#endif
+
+    // Scalar fallback for the remaining positions
+    evaluatePickupPositionsScalar(batch, p, batch.count);
+}
@@ -0,0 +1,233 @@
+#include "localsearch.h"
+
+LocalOptimizer::LocalOptimizer(Solution* solution) {
+    this->solution = solution;
+    this->dontLook.assign(solution->problem->noCalls, false);
+    this->routeSegments.resize(solution->problem->noVehicles);
+}
+
+int LocalOptimizer::run() {
+    // Release all scratch memory of the route segments when done
+    ArenaScope scope;
+    this->solution->getCost();
+
+    // Look at every call whose bit is not set, until a pass finds no improving move
+    int improvements = 0, checked = -1;
+    while (checked != improvements) {
+        checked = improvements;
+        bool improved = true;
+        while (improved) {
+            improved = false;
+            for (int callIndex = 1; callIndex <= this->solution->problem->noCalls; callIndex++) {
+                if (this->dontLook[callIndex-1]) {
+                    continue;
+                }
+                this->dontLook[callIndex-1] = true;
+
+                if (this->relocate(callIndex) || this->swap(callIndex) || this->orOpt(callIndex)) {
+                    improvements++;
+                    improved = true;
+                }
+            }
+        }
+
+        // Bits only reset for calls in changed routes, so look at all calls once more to be sure of a local optimum
+        if (checked != improvements) {
+            this->dontLook.assign(this->dontLook.size(), false);
+        }
+    }
+
+    // Segments live in the arena, so they may not outlive the scope
+    for (std::optional<RouteSegments>& segments : this->routeSegments) {
+        segments.reset();
+    }
+    this->reducedSegments.reset();
+    return improvements;
+}
+
+bool LocalOptimizer::relocate(int callIndex) {
+    Solution* solution = this->solution;
+    Call& call = solution->problem->calls[callIndex-1];
+    auto [sourceVehicle, indices, removed] = solution->callDetails[callIndex-1];
+
+    // Find the change in cost of taking the call out, and the source route without it
+    int removalDelta = -call.costOfNotTransporting;
+    std::vector<int>& reducedRoute = this->reducedRoute;
+    if (sourceVehicle != solution->outsourceVehicle) {
+        Vehicle& source = solution->problem->vehicles[sourceVehicle-1];
+        RouteSegments& sourceSegments = this->segments(sourceVehicle);
+        Segment reduced = concatenate(source, concatenate(source, sourceSegments.prefix(indices.first), sourceSegments.between(indices.first+1, indices.second)), sourceSegments.between(indices.second+1, sourceSegments.stops));
+        if (!isSegmentFeasible(source, reduced)) {
+            return false;
+        }
+        removalDelta = reduced.cost - solution->costs[sourceVehicle-1];
+
+        // Outsourcing the call may already be an improvement
+        if (removalDelta + call.costOfNotTransporting < 0) {
+            solution->outsource(callIndex);
+            solution->updateFeasibility(sourceVehicle);
+            this->changed(sourceVehicle);
+            return true;
+        }
+
+        reducedRoute.assign(solution->representation[sourceVehicle-1].begin(), solution->representation[sourceVehicle-1].end());
+        reducedRoute.erase(reducedRoute.begin() + indices.second);
+        reducedRoute.erase(reducedRoute.begin() + indices.first);
+    }
+
+    for (int vehicleIndex : call.possibleVehicles) {
+        // Positions in the own route are taken in the route without the call
+        Vehicle& vehicle = solution->problem->vehicles[vehicleIndex-1];
+        if (vehicleIndex == sourceVehicle) {
+            this->reducedSegments.emplace(vehicleIndex, reducedRoute, solution);
+        }
+        RouteSegments& segments = (vehicleIndex == sourceVehicle) ? *this->reducedSegments : this->segments(vehicleIndex);
+        Segment pickup = stopSegment(vehicle, solution->problem, callIndex, true);
+        Segment delivery = stopSegment(vehicle, solution->problem, callIndex, false);
+
+        for (int pointer1 = 0; pointer1 <= segments.stops; pointer1++) {
+            // Once the pickup itself is late, all later pickups are too
+            Segment picked = concatenate(vehicle, segments.prefix(pointer1), pickup);
+            if (picked.timeWarp > 0) {
+                break;
+            }
+
+            for (int pointer2 = pointer1; pointer2 <= segments.stops; pointer2++) {
+                Segment carried = concatenate(vehicle, concatenate(vehicle, picked, segments.between(pointer1, pointer2)), delivery);
+                if (carried.timeWarp > 0) {
+                    break;
+                }
+
+                // Apply the first improving position
+                Segment route = concatenate(vehicle, carried, segments.between(pointer2, segments.stops));
+                int insertedCost = (vehicleIndex == sourceVehicle) ? removalDelta + solution->costs[vehicleIndex-1] : solution->costs[vehicleIndex-1];
+                if (isSegmentFeasible(vehicle, route) && removalDelta + route.cost - insertedCost < 0) {
+                    solution->move(vehicleIndex, callIndex, std::make_pair(pointer1, pointer2+1));
+                    if (sourceVehicle != solution->outsourceVehicle && sourceVehicle != vehicleIndex) {
+                        solution->updateFeasibility(sourceVehicle);
+                        this->changed(sourceVehicle);
+                    }
+                    solution->updateFeasibility(vehicleIndex);
+                    this->changed(vehicleIndex);
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+bool LocalOptimizer::swap(int callIndex) {
+    Solution* solution = this->solution;
+    auto [vehicleIndex, indices, removed] = solution->callDetails[callIndex-1];
+    if (vehicleIndex == solution->outsourceVehicle) {
+        return false;
+    }
+    Vehicle& vehicle = solution->problem->vehicles[vehicleIndex-1];
+    RouteSegments& segments = this->segments(vehicleIndex);
+
+    // Lambda evaluating a route where one call takes over the positions of another
+    auto replaced = [&](Vehicle& vehicle, RouteSegments& segments, std::pair<int, int> indices, int callIndex) {
+        Segment route = concatenate(vehicle, segments.prefix(indices.first), stopSegment(vehicle, solution->problem, callIndex, true));
+        route = concatenate(vehicle, route, segments.between(indices.first+1, indices.second));
+        route = concatenate(vehicle, route, stopSegment(vehicle, solution->problem, callIndex, false));
+        return concatenate(vehicle, route, segments.between(indices.second+1, segments.stops));
+    };
+
+    for (int otherVehicle : solution->problem->calls[callIndex-1].possibleVehicles) {
+        if (otherVehicle == vehicleIndex || solution->representation[otherVehicle-1].empty()) {
+            continue;
+        }
+
+        Vehicle& other = solution->problem->vehicles[otherVehicle-1];
+        RouteSegments& otherSegments = this->segments(otherVehicle);
+        for (int i = 0; i < otherSegments.stops; i++) {
+            int otherCall = solution->representation[otherVehicle-1][i];
+            std::pair<int, int> otherIndices = solution->callDetails[otherCall-1].indices;
+            if (otherIndices.first != i || vehicle.possibleCallsSet.find(otherCall) == vehicle.possibleCallsSet.end()) {
+                continue;
+            }
+
+            // Apply the first improving exchange
+            Segment route = replaced(vehicle, segments, indices, otherCall);
+            Segment otherRoute = replaced(other, otherSegments, otherIndices, callIndex);
+            int delta = route.cost + otherRoute.cost - solution->costs[vehicleIndex-1] - solution->costs[otherVehicle-1];
+            if (delta < 0 && isSegmentFeasible(vehicle, route) && isSegmentFeasible(other, otherRoute)) {
+                solution->remove(callIndex);
+                solution->remove(otherCall);
+                solution->add(vehicleIndex, otherCall, indices);
+                solution->add(otherVehicle, callIndex, otherIndices);
+                solution->updateFeasibility(vehicleIndex);
+                solution->updateFeasibility(otherVehicle);
+                this->changed(vehicleIndex);
+                this->changed(otherVehicle);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool LocalOptimizer::orOpt(int callIndex) {
+    Solution* solution = this->solution;
+    auto [vehicleIndex, indices, removed] = solution->callDetails[callIndex-1];
+    if (vehicleIndex == solution->outsourceVehicle || indices.second == indices.first+1) {
+        return false;
+    }
+
+    // The block has to hold both stops of each of its calls
+    std::vector<int>& representation = solution->representation[vehicleIndex-1];
+    for (int i = indices.first; i <= indices.second; i++) {
+        std::pair<int, int> blockIndices = solution->callDetails[representation[i]-1].indices;
+        if (blockIndices.first < indices.first || blockIndices.second > indices.second) {
+            return false;
+        }
+    }
+
+    Vehicle& vehicle = solution->problem->vehicles[vehicleIndex-1];
+    RouteSegments& segments = this->segments(vehicleIndex);
+    int begin = indices.first, end = indices.second+1, length = end - begin;
+    Segment& block = segments.between(begin, end);
+
+    // Try every position of the block in the route without it, numbered by the stop it comes before
+    for (int position = 0; position <= segments.stops - length; position++) {
+        if (position == begin) {
+            continue;
+        }
+
+        Segment route;
+        if (position < begin) {
+            route = concatenate(vehicle, concatenate(vehicle, segments.prefix(position), block), segments.between(position, begin));
+            route = concatenate(vehicle, route, segments.between(end, segments.stops));
+        } else {
+            route = concatenate(vehicle, concatenate(vehicle, segments.prefix(begin), segments.between(end, position + length)), block);
+            route = concatenate(vehicle, route, segments.between(position + length, segments.stops));
+        }
+
+        // Apply the first improving position
+        if (route.cost < solution->costs[vehicleIndex-1] && isSegmentFeasible(vehicle, route)) {
+            std::vector<int> newRoute(representation.begin(), representation.begin() + begin);
+            newRoute.insert(newRoute.end(), representation.begin() + end, representation.end());
+            newRoute.insert(newRoute.begin() + position, representation.begin() + begin, representation.begin() + end);
+            solution->replaceRoute(vehicleIndex, newRoute);
+            this->changed(vehicleIndex);
+            return true;
+        }
+    }
+    return false;
+}
+
+RouteSegments& LocalOptimizer::segments(int vehicleIndex) {
+    std::optional<RouteSegments>& segments = this->routeSegments[vehicleIndex-1];
+    if (!segments) {
+        segments.emplace(vehicleIndex, this->solution->representation[vehicleIndex-1], this->solution);
+    }
+    return *segments;
+}
+
+void LocalOptimizer::changed(int vehicleIndex) {
+    this->routeSegments[vehicleIndex-1].reset();
+    for (int callIndex : this->solution->representation[vehicleIndex-1]) {
+        this->dontLook[callIndex-1] = false;
+    }
+}
@@ -1,93 +1,31 @@
-#include <thread>
-#include <mutex>
-#include <chrono>
+#include <random>
 
-#include "testcase.h"
-#include "solution.h"
-#include "parser.h"
+#include "scheduler.h"
 #include "debug.h"
-#include "heuristics.h"
 
 int main(int argc, char const *argv[])
 {
-    // Total number of experiments to run each algorithm for
+    // Total number of experiments to run each job for, when to stop them early, and the jobs given on the command line or in a job file
     int experiments = 1;
-
-    // Declare each instance to run
-    std::vector<std::pair<std::string, double>> instances = {
-                                                          {"Call_7_Vehicle_3", 0.5}, 
-                                                          {"Call_18_Vehicle_5", 2.0}, 
-                                                          {"Call_35_Vehicle_7", 15.0}, 
-                                                          {"Call_80_Vehicle_20", 15.0}, 
-                                                          {"Call_130_Vehicle_40", 15.0}, 
-                                                          {"Call_300_Vehicle_90", 15.0}
-                                                          };
-    
-    // Then run each instance in a multithreaded fashion
-    std::vector<AlgorithmInformation> outputs;
-    std::mutex outputsMutex;
-    std::vector<std::thread> threads;
-    for (int i = 2; i < instances.size(); i++) {
-        std::string instance = instances[i].first;
-        double time = instances[i].second;
-
-        // Initialize a random number generator
-        std::default_random_engine rng{std::random_device {}()};
-
-        // Create a adaptive neighbourhood operator
-        Operator* adaptiveOperator = new AdaptiveOperator({
-            new SimilarGreedyInsert(),
-            new SimilarRegretInsert(),
-            new CostlyGreedyInsert(),
-            new CostlyRegretInsert(),
-            new RandomGreedyInsert(),
-            new RandomRegretInsert(),
-        });
-
-        // Start a thread running the algorithm
-        threads.emplace_back([i, &outputsMutex, &outputs, adaptiveOperator, instance, experiments, time, &rng](){
-            // Get results
-            AlgorithmInformation output = InstanceRunner::finalAdaptiveMetaheuristic(adaptiveOperator, instance, experiments, time, rng, "");
-
-            // Sleep for ordering and push into vector
-            std::this_thread::sleep_for(std::chrono::milliseconds(i*50));
-            outputsMutex.lock();
-            outputs.push_back(output);
-            outputsMutex.unlock();
-        });
-    }
-
-    // Run first two instances in main thread
-    for (int i = 0; i < 2; i++) {
-        std::string instance = instances[i].first;
-        double time = instances[i].second;
-
-        // Initialize a random number generator
-        std::default_random_engine rng{std::random_device {}()};
-
-        // Create a adaptive neighbourhood operator
-        Operator* adaptiveOperator = new AdaptiveOperator({
-            new SimilarGreedyInsert(),
-            new SimilarRegretInsert(),
-            new CostlyGreedyInsert(),
-            new CostlyRegretInsert(),
-            new RandomGreedyInsert(),
-            new RandomRegretInsert(),
-        });
-
-        // Get results and push into vector
-        AlgorithmInformation output = InstanceRunner::finalAdaptiveMetaheuristic(adaptiveOperator, instance, experiments, time, rng, "");
-        outputsMutex.lock();
-        outputs.push_back(output);
-        outputsMutex.unlock();
+    TerminationCriteria criteria = DEADLINE_ONLY;
+    std::vector<Job> jobs = Scheduler::parseArguments(argc, argv, experiments, criteria);
+
+    // Without any given, run every instance, the largest one as islands on every core,
+    // and the others in batches growing with the cores freed up by instances that converged
+    if (jobs.empty()) {
+        unsigned int seed = std::random_device {}();
+        jobs = {
+            {"Call_7_Vehicle_3", "batch", seed, 0.5, 0},
+            {"Call_18_Vehicle_5", "batch", seed, 2.0, 0},
+            {"Call_35_Vehicle_7", "batch", seed, 15.0, 0},
+            {"Call_80_Vehicle_20", "batch", seed, 15.0, 0},
+            {"Call_130_Vehicle_40", "batch", seed, 15.0, 0},
+            {"Call_300_Vehicle_90", "island", seed, 15.0, 0}
+        };
     }
-    
-
 
-    // Wait for all threads to finish
-    for (std::thread& thread : threads) {
-        thread.join();
-    }
+    // Run all jobs on the shared thread pool
+    std::vector<AlgorithmInformation> outputs = Scheduler::run(jobs, experiments, criteria);
 
     // And output information
     Debugger::outputToFile("results_final.txt");
@@ -97,65 +35,14 @@ int main(int argc, char const *argv[])
             std::cout << "Cost: " << std::to_string(episode.greedyCost);
             
             std::cout << " Actual: " << std::to_string(episode.actualCost) << ", found after iteration " << std::to_string(episode.iterfound) << " (" << Debugger::formatDouble(episode.timefound, 2) << " seconds)" << std::endl;
-            std::cout << "Experiment ran for " << std::to_string(episode.totalIterations) << " iterations." << std::endl;
-        }
-
-        Debugger::printResults(information.instance, information.algorithm, information.averageObjective, information.bestSolution.getCost(), information.improvement, information.averageTime, &(information.bestSolution));
-    }
-
-    return 0;
-}
-
-
-/* 
-// Uncomment in case multithreaded algorithm does not run as expected.
-
-int main(int argc, char const *argv[])
-{
-    // Total number of experiments to run each algorithm for
-    int experiments = 1;
-
-    // Declare each instance to run
-    std::vector<std::pair<std::string, double>> instances = {{"Call_7_Vehicle_3", 0.01}, 
-                                                          {"Call_18_Vehicle_5", 0.04}, 
-                                                          {"Call_35_Vehicle_7", 2.0}, 
-                                                          {"Call_80_Vehicle_20", 3.95}, 
-                                                          {"Call_130_Vehicle_40", 9.0}};
-    
-    // Then run each instance in the main thread
-    Debugger::outputToFile("results_final.txt");
-    for (int i = 0; i < instances.size(); i++) {
-        std::string instance = instances[i].first;
-        double time = instances[i].second;
-
-        // Initialize a random number generator
-        std::default_random_engine rng{std::random_device {}()};
-
-        // Create a adaptive neighbourhood operator
-        Operator* adaptiveOperator = new AdaptiveOperator({
-            new SimilarGreedyInsert(),
-            new SimilarRegretInsert(),
-            new CostlyGreedyInsert(),
-            new CostlyRegretInsert(),
-            new RandomGreedyInsert(),
-            new RandomRegretInsert(),
-        });
-
-        // Get results
-        AlgorithmInformation information = InstanceRunner::finalAdaptiveMetaheuristic(adaptiveOperator, instance, experiments, time, rng, "");
-
-        // And output information
-        for (EpisodeInformation& episode : information.episodes) {
-            Debugger::printSolution(&episode.solution);
-            std::cout << "Cost: " << std::to_string(episode.greedyCost);
-            
-            std::cout << " Actual: " << std::to_string(episode.actualCost) << ", found after iteration " << std::to_string(episode.iterfound) << " (" << Debugger::formatDouble(episode.timefound, 2) << " seconds)" << std::endl;
-            std::cout << "Experiment ran for " << std::to_string(episode.totalIterations) << " iterations." << std::endl;
+            std::cout << "Experiment ran for " << std::to_string(episode.totalIterations) << " iterations, stopped on " << episode.stoppedOn << "." << std::endl;
+            std::cout << "Heap allocations per iteration after warm-up: " << ((episode.heapAllocations < 0) ? "not reached" : Debugger::formatDouble(episode.heapAllocations, 2)) << std::endl;
+            std::cout << "Insertion cache hits: " << std::to_string(episode.insertionCacheHits) << ", misses: " << std::to_string(episode.insertionCacheMisses) << std::endl;
         }
 
+        std::cout << "Route cache hit rate: " << Debugger::formatDouble(100 * information.routeCacheHitRate, 2) << "%" << std::endl;
         Debugger::printResults(information.instance, information.algorithm, information.averageObjective, information.bestSolution.getCost(), information.improvement, information.averageTime, &(information.bestSolution));
     }
 
     return 0;
 }
-*/
\ No newline at end of file
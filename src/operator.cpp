@@ -1,12 +1,75 @@
 #include "operator.h"
 
+#include <cmath>
+#include <chrono>
+#include <numeric>
+
 #include "debug.h"
+#include "threadpool.h"
+
+Solution Operator::applyBatch(Solution* solution, int iteration, int batchSize, Xoshiro256& rng) {
+    if (batchSize <= 1) {
+        return this->apply(solution, iteration, rng);
+    }
+
+    // Fill the caches of the solution up front, as the neighbours only read it
+    solution->getCost();
+    solution->isFeasible();
+
+    // Seed a random number generator per neighbour
+    std::vector<Xoshiro256> rngs;
+    for (int b = 0; b < batchSize; b++) {
+        rngs.push_back(rng.split());
+    }
+
+    // Generate the neighbours concurrently
+    std::vector<std::optional<Solution>> generated(batchSize);
+    ThreadPool::shared().parallelFor(0, batchSize, [&](int b) {
+        generated[b] = this->apply(solution, iteration, rngs[b]);
+    });
+    std::vector<Solution> neighbours;
+    for (std::optional<Solution>& neighbour : generated) {
+        neighbours.push_back(std::move(*neighbour));
+    }
+
+    // And return the best of them
+    return neighbours[Operator::bestOfBatch(neighbours)];
+}
+
+void Operator::setDeadline(double remaining, double secondsLeft) {
+    // Most operators do the same regardless of the deadline
+}
+
+int Operator::bestOfBatch(std::vector<Solution>& neighbours) {
+    int best = 0;
+    for (int b = 0; b < neighbours.size(); b++) {
+        if (!neighbours[b].isFeasible()) {
+            continue;
+        }
+        if (!neighbours[best].isFeasible() || neighbours[b].getCost() < neighbours[best].getCost()) {
+            best = b;
+        }
+    }
+    return best;
+}
+
+Solution Operator::timedApply(Operator* neighbourOperator, Solution* solution, int iteration, Xoshiro256& rng, double& seconds, int& calls) {
+    // The steady clock is read without a system call, which is negligible next to any operator
+    takeSampledCalls();
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    Solution newSolution = neighbourOperator->apply(solution, iteration, rng);
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    calls = takeSampledCalls();
+    return newSolution;
+}
 
 UniformOperator::UniformOperator(std::vector<Operator*> operators) {
-    this->operators = operators;
+    for (Operator* op : operators) {
+        this->operators.emplace_back(op);
+    }
 }
 
-Solution UniformOperator::apply(Solution* solution, int iteration, std::default_random_engine& rng) {
+Solution UniformOperator::apply(Solution* solution, int iteration, Xoshiro256& rng) {
     // Get a random operator from those this contains
     int operatorIndex = std::uniform_int_distribution<std::size_t>(0, this->operators.size()-1)(rng);
 
@@ -16,29 +79,64 @@ Solution UniformOperator::apply(Solution* solution, int iteration, std::default_
 
 WeightedOperator::WeightedOperator(std::vector<std::pair<Operator*, double>> operators) {
     for (std::pair<Operator*, double> op : operators) {
-        this->operators.push_back(op.first);
+        this->operators.emplace_back(op.first);
         this->weights.push_back(op.second);
     }
+    this->table.build(this->weights);
 }
 
-Solution WeightedOperator::apply(Solution* solution, int iteration, std::default_random_engine& rng) {
+Solution WeightedOperator::apply(Solution* solution, int iteration, Xoshiro256& rng) {
     // Get a weighted random operator from those this contains
-    int operatorIndex = std::discrete_distribution<std::size_t>(this->weights.begin(), this->weights.end())(rng);
+    int operatorIndex = this->table.sample(rng);
 
     // Apply it
     return this->operators[operatorIndex]->apply(solution, iteration, rng);
 }
 
-AdaptiveOperator::AdaptiveOperator(std::vector<Operator*> operators) {
-    this->operators = operators;
+void OperatorCost::record(int calls, double seconds) {
+    this->count++;
+    this->sumCalls += calls;
+    this->sumSeconds += seconds;
+    this->sumCallsSquared += (double)calls * calls;
+    this->sumCallsSeconds += calls * seconds;
+}
+
+double OperatorCost::predict(double calls) {
+    if (this->count == 0) {
+        return 0;
+    }
+
+    // Fall back to the mean time if the calls moved never varied, as for operators that don't sample them
+    double meanCalls = this->sumCalls / this->count;
+    double meanSeconds = this->sumSeconds / this->count;
+    double variance = this->sumCallsSquared / this->count - meanCalls * meanCalls;
+    if (variance < 1e-9) {
+        return meanSeconds;
+    }
+
+    // Otherwise follow the least squares line, never predicting less than no time at all
+    double slope = (this->sumCallsSeconds / this->count - meanCalls * meanSeconds) / variance;
+    return std::max(0.0, meanSeconds + slope * (calls - meanCalls));
+}
+
+long long OperatorCost::applications() {
+    return this->count;
+}
+
+AdaptiveOperator::AdaptiveOperator(std::vector<Operator*> operators, bool timeAware) {
+    for (Operator* op : operators) {
+        this->operators.emplace_back(op);
+    }
+    this->timeAware = timeAware;
     this->weights.resize(operators.size());
     this->scores.resize(operators.size());
     this->uses.resize(operators.size());
+    this->costs.resize(operators.size());
 
     this->reset();
 }
 
-Solution AdaptiveOperator::apply(Solution* solution, int iteration, std::default_random_engine& rng) {
+Solution AdaptiveOperator::apply(Solution* solution, int iteration, Xoshiro256& rng) {
     // If first iteration, reset the weights
     if (iteration == 0) {
         this->reset();
@@ -50,17 +148,92 @@ Solution AdaptiveOperator::apply(Solution* solution, int iteration, std::default
     }
 
     // Get a weighted random operator from those this contains
-    int operatorIndex = std::discrete_distribution<std::size_t>(this->weights.begin(), this->weights.end())(rng);
+    int operatorIndex = this->table.sample(rng);
     this->lastOperatorUsed = operatorIndex;
 
-    // Apply it
-    Solution newSolution = this->operators[operatorIndex]->apply(solution, iteration, rng);
+    // Apply it, measuring its wall time
+    double seconds;
+    int calls;
+    Solution newSolution = Operator::timedApply(this->operators[operatorIndex].get(), solution, iteration, rng, seconds, calls);
 
+    // Score the operator
+    this->recordCost(operatorIndex, seconds, calls);
+    this->score(operatorIndex, solution, newSolution);
+
+    // And return it
+    return newSolution;
+}
+
+Solution AdaptiveOperator::applyBatch(Solution* solution, int iteration, int batchSize, Xoshiro256& rng) {
+    if (batchSize <= 1) {
+        return this->apply(solution, iteration, rng);
+    }
+
+    // If first iteration, reset the weights
+    if (iteration == 0) {
+        this->reset();
+    }
+
+    // else if iterations are a multiple of 100, recalculate adaptive weights
+    else if (iteration % 100 == 0) {
+        this->update();
+    }
+
+    // Draw an operator and seed a random number generator per neighbour
+    std::vector<int> operatorIndices;
+    std::vector<Xoshiro256> rngs;
+    for (int b = 0; b < batchSize; b++) {
+        operatorIndices.push_back(this->table.sample(rng));
+        rngs.push_back(rng.split());
+    }
+
+    // Fill the caches of the solution up front, as the neighbours only read it
+    solution->getCost();
+    solution->isFeasible();
+
+    // Generate the neighbours concurrently, measuring the wall time of each on its own thread
+    std::vector<std::optional<Solution>> generated(batchSize);
+    std::vector<double> seconds(batchSize);
+    std::vector<int> calls(batchSize);
+    ThreadPool::shared().parallelFor(0, batchSize, [&](int b) {
+        generated[b] = Operator::timedApply(this->operators[operatorIndices[b]].get(), solution, iteration, rngs[b], seconds[b], calls[b]);
+    });
+    std::vector<Solution> neighbours;
+    for (std::optional<Solution>& neighbour : generated) {
+        neighbours.push_back(std::move(*neighbour));
+    }
+
+    // Score every operator in order of the batch
+    for (int b = 0; b < batchSize; b++) {
+        this->recordCost(operatorIndices[b], seconds[b], calls[b]);
+        this->score(operatorIndices[b], solution, neighbours[b]);
+    }
+
+    // And return the best neighbour
+    int best = Operator::bestOfBatch(neighbours);
+    this->lastOperatorUsed = operatorIndices[best];
+    return neighbours[best];
+}
+
+void AdaptiveOperator::setDeadline(double remaining, double secondsLeft) {
+    this->remaining = remaining;
+    this->secondsLeft = secondsLeft;
+}
+
+void AdaptiveOperator::recordCost(int operatorIndex, double seconds, int calls) {
+    this->costs[operatorIndex].record(calls, seconds);
+
+    // Keep the mean number of calls moved by the operators that sample it, to predict their time at
+    if (calls > 0) {
+        this->sampledApplications++;
+        this->averageCalls += (calls - this->averageCalls) / this->sampledApplications;
+    }
+}
+
+void AdaptiveOperator::score(int operatorIndex, Solution* solution, Solution& newSolution) {
     // Add a use to the current operator
     this->uses[operatorIndex]++;
 
-    int deltaCost = solution->getCost() - newSolution.getCost();
-
     // Update scoring based on how good the new solution is
     if (newSolution.getCost() < bestCost) {
         // New best solution
@@ -74,12 +247,25 @@ Solution AdaptiveOperator::apply(Solution* solution, int iteration, std::default
         seenSolutions.insert(newSolution);
         this->scores[operatorIndex] += 1;
     }
-
-    // And return it
-    return newSolution;
 }
 
 void AdaptiveOperator::update() {
+    // Predict the wall time of every operator at the mean calls moved, and their mean
+    std::vector<double> predicted(this->operators.size());
+    double meanPredicted = 0;
+    int timed = 0;
+    for (int i = 0; i < this->operators.size(); i++) {
+        predicted[i] = this->costs[i].predict(this->averageCalls);
+        if (this->costs[i].applications() > 0) {
+            meanPredicted += predicted[i];
+            timed++;
+        }
+    }
+    meanPredicted /= std::max(1, timed);
+
+    // Only credit by wall time in searches bounded by time, so searches bounded by iterations stay deterministic
+    bool timeCredit = this->timeAware && std::isfinite(this->secondsLeft);
+
     // Store sum for normalization later
     double sum = 0;
 
@@ -88,7 +274,18 @@ void AdaptiveOperator::update() {
 
         // Don't add to weight if operator wasn't used
         if (this->uses[i] > 0) {
-            this->weights[i] += r * this->scores[i] / (double)this->uses[i];
+            double reward = this->scores[i] / (double)this->uses[i];
+
+            // Relative to the mean operator, credit per second of wall time, more so the closer the deadline
+            if (timeCredit && predicted[i] > 0 && meanPredicted > 0) {
+                reward *= std::pow(meanPredicted / predicted[i], 1.0 - this->remaining);
+            }
+            this->weights[i] += r * reward;
+        }
+
+        // Operators not expected to finish before the deadline are barely worth choosing
+        if (timeCredit && predicted[i] > this->secondsLeft) {
+            this->weights[i] = 0;
         }
 
         // Also ensure weights never become zero
@@ -110,6 +307,9 @@ void AdaptiveOperator::update() {
         //Debugger::printToTerminal(std::to_string(this->weights[i]) + ", ");
     }
     //Debugger::printToTerminal("]\n");
+
+    // Rebuild the table for sampling the weights
+    this->table.build(this->weights);
 }
 
 void AdaptiveOperator::reset() {
@@ -123,9 +323,225 @@ void AdaptiveOperator::reset() {
     }
     // Reset seen solutions
     this->seenSolutions.clear();
+
+    // Reset the cost model, as a new search may be on another instance
+    this->costs.assign(this->operators.size(), OperatorCost());
+    this->averageCalls = 0;
+    this->sampledApplications = 0;
+
+    // Rebuild the table for sampling the weights
+    this->table.build(this->weights);
 }
 
-Solution SimilarGreedyInsert::apply(Solution* solution, int iteration, std::default_random_engine& rng) {
+BanditOperator::BanditOperator(std::vector<Operator*> operators, double exploration) {
+    for (Operator* op : operators) {
+        this->operators.emplace_back(op);
+    }
+    this->exploration = exploration;
+    this->inverses.resize(operators.size());
+    this->rewardSums.resize(operators.size());
+
+    this->reset();
+}
+
+Solution BanditOperator::apply(Solution* solution, int iteration, Xoshiro256& rng) {
+    // If first iteration, forget what was learned in a previous search
+    if (iteration == 0) {
+        this->reset();
+    }
+
+    // Draw an operator by its bound in the current state
+    BanditContext features = this->context(solution, iteration);
+    this->bound(features);
+    int operatorIndex = this->table.sample(rng);
+    this->lastOperatorUsed = operatorIndex;
+
+    // Apply it, measuring its wall time
+    double seconds;
+    int calls;
+    Solution newSolution = Operator::timedApply(this->operators[operatorIndex].get(), solution, iteration, rng, seconds, calls);
+
+    // Learn from the outcome
+    this->learn(operatorIndex, features, solution, newSolution, iteration, seconds, calls);
+
+    // And return it
+    return newSolution;
+}
+
+Solution BanditOperator::applyBatch(Solution* solution, int iteration, int batchSize, Xoshiro256& rng) {
+    if (batchSize <= 1) {
+        return this->apply(solution, iteration, rng);
+    }
+
+    // If first iteration, forget what was learned in a previous search
+    if (iteration == 0) {
+        this->reset();
+    }
+
+    // Draw an operator by its bound in the current state and seed a random number generator per neighbour
+    BanditContext features = this->context(solution, iteration);
+    this->bound(features);
+    std::vector<int> operatorIndices;
+    std::vector<Xoshiro256> rngs;
+    for (int b = 0; b < batchSize; b++) {
+        operatorIndices.push_back(this->table.sample(rng));
+        rngs.push_back(rng.split());
+    }
+
+    // Fill the caches of the solution up front, as the neighbours only read it
+    solution->getCost();
+    solution->isFeasible();
+
+    // Generate the neighbours concurrently, measuring the wall time of each on its own thread
+    std::vector<std::optional<Solution>> generated(batchSize);
+    std::vector<double> seconds(batchSize);
+    std::vector<int> calls(batchSize);
+    ThreadPool::shared().parallelFor(0, batchSize, [&](int b) {
+        generated[b] = Operator::timedApply(this->operators[operatorIndices[b]].get(), solution, iteration, rngs[b], seconds[b], calls[b]);
+    });
+    std::vector<Solution> neighbours;
+    for (std::optional<Solution>& neighbour : generated) {
+        neighbours.push_back(std::move(*neighbour));
+    }
+
+    // Learn from every outcome in order of the batch
+    for (int b = 0; b < batchSize; b++) {
+        this->learn(operatorIndices[b], features, solution, neighbours[b], iteration, seconds[b], calls[b]);
+    }
+
+    // And return the best neighbour
+    int best = Operator::bestOfBatch(neighbours);
+    this->lastOperatorUsed = operatorIndices[best];
+    return neighbours[best];
+}
+
+void BanditOperator::setDeadline(double remaining, double secondsLeft) {
+    this->remaining = remaining;
+}
+
+BanditContext BanditOperator::context(Solution* solution, int iteration) {
+    Problem* problem = solution->problem;
+    return {
+        1.0,
+        std::max(0.0, std::min(1.0, this->remaining)),
+        std::min(1.0, (iteration - this->lastBestFound) / (double)BANDIT_STAGNATION),
+        solution->representation[solution->outsourceVehicle-1].size() / (2.0 * problem->noCalls),
+        std::min(1.0, this->lastCalls / (double)problem->noCalls)
+    };
+}
+
+void BanditOperator::bound(BanditContext& features) {
+    // Upper confidence bound of every operator: predicted reward plus the uncertainty of the prediction
+    std::vector<double> bounds(this->operators.size());
+    for (int i = 0; i < this->operators.size(); i++) {
+        double predicted = 0, variance = 0;
+        for (int j = 0; j < BANDIT_FEATURES; j++) {
+            double inverseFeatures = 0, inverseRewards = 0;
+            for (int k = 0; k < BANDIT_FEATURES; k++) {
+                inverseFeatures += this->inverses[i][j][k] * features[k];
+                inverseRewards += this->inverses[i][j][k] * this->rewardSums[i][k];
+            }
+            predicted += features[j] * inverseRewards;
+            variance += features[j] * inverseFeatures;
+        }
+        bounds[i] = std::max(0.0, predicted + this->exploration * std::sqrt(std::max(0.0, variance)));
+    }
+
+    // Divide the bounds by the wall time of the operators relative to the mean, to get the reward per second
+    double totalSeconds = 0, highest = 0;
+    long long totalUses = 0;
+    for (int i = 0; i < this->operators.size(); i++) {
+        totalSeconds += this->seconds[i];
+        totalUses += this->uses[i];
+    }
+    for (int i = 0; i < this->operators.size(); i++) {
+        if (this->uses[i] > 0 && totalSeconds > 0) {
+            bounds[i] /= std::max(this->seconds[i] / this->uses[i], 1e-9) * totalUses / totalSeconds;
+            highest = std::max(highest, bounds[i]);
+        }
+    }
+
+    // Operators not yet tried are as likely as the best one, and every operator keeps a small chance
+    double sum = 0;
+    for (int i = 0; i < this->operators.size(); i++) {
+        if (this->uses[i] == 0) {
+            bounds[i] = (highest > 0) ? highest : 1.0;
+        }
+        sum += bounds[i];
+    }
+    for (int i = 0; i < this->operators.size(); i++) {
+        bounds[i] = std::max(bounds[i] / sum, 0.01);
+    }
+
+    // And rebuild the table for sampling them
+    this->table.build(bounds);
+}
+
+void BanditOperator::learn(int operatorIndex, BanditContext& features, Solution* solution, Solution& newSolution, int iteration, double seconds, int calls) {
+    // Keep the wall time of every operator
+    this->seconds[operatorIndex] += seconds;
+    this->uses[operatorIndex]++;
+    if (calls > 0) {
+        this->lastCalls = calls;
+    }
+
+    // The first solution applied on is the best one seen so far
+    if (this->bestCost == INT_MAX && solution->isFeasible()) {
+        this->bestCost = solution->getCost();
+    }
+
+    // Reward the relative improvement of the solution, in percent, and finding a new best solution
+    double reward = 0;
+    if (newSolution.isFeasible() && newSolution.getCost() < solution->getCost()) {
+        reward = 100.0 * (solution->getCost() - newSolution.getCost()) / solution->getCost();
+    }
+    if (newSolution.isFeasible() && newSolution.getCost() < this->bestCost) {
+        this->bestCost = newSolution.getCost();
+        this->lastBestFound = iteration;
+        reward += 1.0;
+    }
+
+    // Update the inverse covariance of the operator with the Sherman-Morrison formula, and its reward-weighted features
+    std::array<BanditContext, BANDIT_FEATURES>& inverse = this->inverses[operatorIndex];
+    BanditContext inverseFeatures = {};
+    double denominator = 1.0;
+    for (int j = 0; j < BANDIT_FEATURES; j++) {
+        for (int k = 0; k < BANDIT_FEATURES; k++) {
+            inverseFeatures[j] += inverse[j][k] * features[k];
+        }
+        denominator += features[j] * inverseFeatures[j];
+    }
+    for (int j = 0; j < BANDIT_FEATURES; j++) {
+        for (int k = 0; k < BANDIT_FEATURES; k++) {
+            inverse[j][k] -= inverseFeatures[j] * inverseFeatures[k] / denominator;
+        }
+        this->rewardSums[operatorIndex][j] += reward * features[j];
+    }
+}
+
+void BanditOperator::reset() {
+    // Start every operator from the identity covariance and no rewards
+    for (int i = 0; i < this->operators.size(); i++) {
+        for (int j = 0; j < BANDIT_FEATURES; j++) {
+            this->inverses[i][j].fill(0);
+            this->inverses[i][j][j] = 1.0;
+        }
+        this->rewardSums[i].fill(0);
+    }
+
+    // And from a fresh search state
+    this->remaining = 1.0;
+    this->bestCost = INT_MAX;
+    this->lastBestFound = 0;
+    this->lastCalls = 0;
+    this->seconds.assign(this->operators.size(), 0);
+    this->uses.assign(this->operators.size(), 0);
+}
+
+Solution SimilarGreedyInsert::apply(Solution* solution, int iteration, Xoshiro256& rng) {
+    // Release all scratch memory of the heuristics when done
+    ArenaScope scope;
+
     // Create a copy of the current solution
     Solution current = solution->copy();
 
@@ -133,17 +549,20 @@ Solution SimilarGreedyInsert::apply(Solution* solution, int iteration, std::defa
     int callsToMove = boundedUniformSample(solution, iteration, rng);
 
     // Remove similar calls
-    std::vector<int> removedCalls = removeSimilar(callsToMove, &current, rng);
+    ScratchVector<int> removedCalls = removeSimilar(callsToMove, &current, rng);
 
     // Insert them using greedy
-    std::set<int> callIndices(removedCalls.begin(), removedCalls.end());
-    insertGreedy(callIndices, &current);
+    std::sort(removedCalls.begin(), removedCalls.end());
+    insertGreedy(removedCalls, &current);
 
     // Return the neighbour solution
     return current;
 }
 
-Solution SimilarRegretInsert::apply(Solution* solution, int iteration, std::default_random_engine& rng) {
+Solution SimilarRegretInsert::apply(Solution* solution, int iteration, Xoshiro256& rng) {
+    // Release all scratch memory of the heuristics when done
+    ArenaScope scope;
+
     // Create a copy of the current solution
     Solution current = solution->copy();
 
@@ -151,20 +570,23 @@ Solution SimilarRegretInsert::apply(Solution* solution, int iteration, std::defa
     int callsToMove = boundedUniformSample(solution, iteration, rng);
 
     // Remove similar calls
-    std::vector<int> removedCalls = removeSimilar(callsToMove, &current, rng);
+    ScratchVector<int> removedCalls = removeSimilar(callsToMove, &current, rng);
 
     // Infer k from current iteration
     int k = std::uniform_int_distribution<int>(2, 4)(rng);
 
     // Insert them using greedy
-    std::set<int> callIndices(removedCalls.begin(), removedCalls.end());
-    insertRegret(callIndices, &current, k);
+    std::sort(removedCalls.begin(), removedCalls.end());
+    insertRegret(removedCalls, &current, k);
 
     // Return the neighbour solution
     return current;
 }
 
-Solution SimilarBeamInsert::apply(Solution* solution, int iteration, std::default_random_engine& rng) {
+Solution SimilarBeamInsert::apply(Solution* solution, int iteration, Xoshiro256& rng) {
+    // Release all scratch memory of the heuristics when done
+    ArenaScope scope;
+
     // Create a copy of the current solution
     Solution current = solution->copy();
 
@@ -172,20 +594,23 @@ Solution SimilarBeamInsert::apply(Solution* solution, int iteration, std::defaul
     int callsToMove = boundedUniformSample(solution, iteration, rng);
 
     // Remove similar calls
-    std::vector<int> removedCalls = removeSimilar(callsToMove, &current, rng);
+    ScratchVector<int> removedCalls = removeSimilar(callsToMove, &current, rng);
 
     // Sample a random beam width size
     int width = std::uniform_int_distribution<int>(2, 4)(rng);
 
     // Insert them using greedy
-    std::set<int> callIndices(removedCalls.begin(), removedCalls.end());
-    insertBeam(callIndices, &current, width);
+    std::sort(removedCalls.begin(), removedCalls.end());
+    insertBeam(removedCalls, &current, width);
 
     // Return the neighbour solution
     return current;
 }
 
-Solution CostlyGreedyInsert::apply(Solution* solution, int iteration, std::default_random_engine& rng) {
+Solution CostlyGreedyInsert::apply(Solution* solution, int iteration, Xoshiro256& rng) {
+    // Release all scratch memory of the heuristics when done
+    ArenaScope scope;
+
     // Create a copy of the current solution
     Solution current = solution->copy();
 
@@ -193,17 +618,20 @@ Solution CostlyGreedyInsert::apply(Solution* solution, int iteration, std::defau
     int callsToMove = boundedUniformSample(solution, iteration, rng);
 
     // Remove current most costly calls
-    std::vector<int> removedCalls = removeCostly(callsToMove, &current, rng);
+    ScratchVector<int> removedCalls = removeCostly(callsToMove, &current, rng);
 
     // Insert them using greedy
-    std::set<int> callIndices(removedCalls.begin(), removedCalls.end());
-    insertGreedy(callIndices, &current);
+    std::sort(removedCalls.begin(), removedCalls.end());
+    insertGreedy(removedCalls, &current);
 
     // Return the neighbour solution
     return current;
 }
 
-Solution CostlyRegretInsert::apply(Solution* solution, int iteration, std::default_random_engine& rng) {
+Solution CostlyRegretInsert::apply(Solution* solution, int iteration, Xoshiro256& rng) {
+    // Release all scratch memory of the heuristics when done
+    ArenaScope scope;
+
     // Create a copy of the current solution
     Solution current = solution->copy();
 
@@ -211,20 +639,23 @@ Solution CostlyRegretInsert::apply(Solution* solution, int iteration, std::defau
     int callsToMove = boundedUniformSample(solution, iteration, rng);
 
     // Remove current most costly calls
-    std::vector<int> removedCalls = removeCostly(callsToMove, &current, rng);
+    ScratchVector<int> removedCalls = removeCostly(callsToMove, &current, rng);
 
     // Infer k from current iteration
     int k = std::uniform_int_distribution<int>(2, 4)(rng);
 
     // Insert them using greedy
-    std::set<int> callIndices(removedCalls.begin(), removedCalls.end());
-    insertRegret(callIndices, &current, k);
+    std::sort(removedCalls.begin(), removedCalls.end());
+    insertRegret(removedCalls, &current, k);
 
     // Return the neighbour solution
     return current;
 }
 
-Solution CostlyBeamInsert::apply(Solution* solution, int iteration, std::default_random_engine& rng) {
+Solution CostlyBeamInsert::apply(Solution* solution, int iteration, Xoshiro256& rng) {
+    // Release all scratch memory of the heuristics when done
+    ArenaScope scope;
+
     // Create a copy of the current solution
     Solution current = solution->copy();
 
@@ -232,20 +663,23 @@ Solution CostlyBeamInsert::apply(Solution* solution, int iteration, std::default
     int callsToMove = boundedUniformSample(solution, iteration, rng);
 
     // Remove current most costly calls
-    std::vector<int> removedCalls = removeCostly(callsToMove, &current, rng);
+    ScratchVector<int> removedCalls = removeCostly(callsToMove, &current, rng);
 
     // Sample a random beam width size
     int width = std::uniform_int_distribution<int>(2, 4)(rng);
 
     // Insert them using greedy
-    std::set<int> callIndices(removedCalls.begin(), removedCalls.end());
-    insertBeam(callIndices, &current, width);
+    std::sort(removedCalls.begin(), removedCalls.end());
+    insertBeam(removedCalls, &current, width);
 
     // Return the neighbour solution
     return current;
 }
 
-Solution RandomGreedyInsert::apply(Solution* solution, int iteration, std::default_random_engine& rng) {
+Solution RandomGreedyInsert::apply(Solution* solution, int iteration, Xoshiro256& rng) {
+    // Release all scratch memory of the heuristics when done
+    ArenaScope scope;
+
     // Create a copy of the current solution
     Solution current = solution->copy();
 
@@ -253,17 +687,20 @@ Solution RandomGreedyInsert::apply(Solution* solution, int iteration, std::defau
     int callsToMove = boundedUniformSample(solution, iteration, rng);
 
     // Remove random calls
-    std::vector<int> removedCalls = removeRandom(callsToMove, &current, rng);
+    ScratchVector<int> removedCalls = removeRandom(callsToMove, &current, rng);
 
     // Insert them using greedy
-    std::set<int> callIndices(removedCalls.begin(), removedCalls.end());
-    insertGreedy(callIndices, &current);
+    std::sort(removedCalls.begin(), removedCalls.end());
+    insertGreedy(removedCalls, &current);
 
     // Return the neighbour solution
     return current;
 }
 
-Solution RandomRegretInsert::apply(Solution* solution, int iteration, std::default_random_engine& rng) {
+Solution RandomRegretInsert::apply(Solution* solution, int iteration, Xoshiro256& rng) {
+    // Release all scratch memory of the heuristics when done
+    ArenaScope scope;
+
     // Create a copy of the current solution
     Solution current = solution->copy();
 
@@ -271,20 +708,23 @@ Solution RandomRegretInsert::apply(Solution* solution, int iteration, std::defau
     int callsToMove = boundedUniformSample(solution, iteration, rng);
 
     // Remove random calls
-    std::vector<int> removedCalls = removeRandom(callsToMove, &current, rng);
+    ScratchVector<int> removedCalls = removeRandom(callsToMove, &current, rng);
 
     // Infer k from current iteration
     int k = std::uniform_int_distribution<int>(2, 4)(rng);
 
     // Insert them using greedy
-    std::set<int> callIndices(removedCalls.begin(), removedCalls.end());
-    insertRegret(callIndices, &current, k);
+    std::sort(removedCalls.begin(), removedCalls.end());
+    insertRegret(removedCalls, &current, k);
 
     // Return the neighbour solution
     return current;
 }
 
-Solution RandomBeamInsert::apply(Solution* solution, int iteration, std::default_random_engine& rng) {
+Solution RandomBeamInsert::apply(Solution* solution, int iteration, Xoshiro256& rng) {
+    // Release all scratch memory of the heuristics when done
+    ArenaScope scope;
+
     // Create a copy of the current solution
     Solution current = solution->copy();
 
@@ -292,21 +732,389 @@ Solution RandomBeamInsert::apply(Solution* solution, int iteration, std::default
     int callsToMove = boundedUniformSample(solution, iteration, rng);
 
     // Remove random calls
-    std::vector<int> removedCalls = removeRandom(callsToMove, &current, rng);
+    ScratchVector<int> removedCalls = removeRandom(callsToMove, &current, rng);
 
     // Sample a random beam width size
     int width = std::uniform_int_distribution<int>(2, 4)(rng);
 
     // Insert them using greedy
-    std::set<int> callIndices(removedCalls.begin(), removedCalls.end());
-    insertBeam(callIndices, &current, width);
+    std::sort(removedCalls.begin(), removedCalls.end());
+    insertBeam(removedCalls, &current, width);
 
     // Return the neighbour solution
     return current;
 }
 
-int boundedUniformSample(Solution* solution, int iteration, std::default_random_engine& rng) {
+Solution RelocateCall::apply(Solution* solution, int iteration, Xoshiro256& rng) {
+    // Release all scratch memory of the route segments when done
+    ArenaScope scope;
+
+    // Create a copy of the current solution
+    Solution current = solution->copy();
+    current.getCost();
+
+    // Pick a random call carried by one of our vehicles
+    ScratchVector<int> carriedCalls;
+    for (int callIndex = 1; callIndex <= current.problem->noCalls; callIndex++) {
+        if (current.callDetails[callIndex-1].vehicle != current.outsourceVehicle) {
+            carriedCalls.push_back(callIndex);
+        }
+    }
+    if (carriedCalls.empty()) {
+        return current;
+    }
+    int callIndex = carriedCalls[std::uniform_int_distribution<int>(0, carriedCalls.size()-1)(rng)];
+    auto [sourceVehicle, indices, removed] = current.callDetails[callIndex-1];
+
+    // Evaluate the source route without the call
+    Vehicle& source = current.problem->vehicles[sourceVehicle-1];
+    RouteSegments sourceSegments(sourceVehicle, current.representation[sourceVehicle-1], &current);
+    Segment reduced = concatenate(source, concatenate(source, sourceSegments.prefix(indices.first), sourceSegments.between(indices.first+1, indices.second)), sourceSegments.between(indices.second+1, sourceSegments.stops));
+    if (!isSegmentFeasible(source, reduced)) {
+        return current;
+    }
+    int removalDelta = reduced.cost - current.costs[sourceVehicle-1];
+
+    // Find the cheapest pickup and delivery positions over all other compatible vehicles
+    int bestDelta = INT_MAX, bestVehicle = 0;
+    std::pair<int, int> bestIndices;
+    for (int vehicleIndex : current.problem->calls[callIndex-1].possibleVehicles) {
+        if (vehicleIndex == sourceVehicle) {
+            continue;
+        }
+
+        Vehicle& vehicle = current.problem->vehicles[vehicleIndex-1];
+        RouteSegments segments(vehicleIndex, current.representation[vehicleIndex-1], &current);
+        Segment pickup = stopSegment(vehicle, current.problem, callIndex, true);
+        Segment delivery = stopSegment(vehicle, current.problem, callIndex, false);
+
+        for (int pointer1 = 0; pointer1 <= segments.stops; pointer1++) {
+            // Once the pickup itself is late, all later pickups are too
+            Segment picked = concatenate(vehicle, segments.prefix(pointer1), pickup);
+            if (picked.timeWarp > 0) {
+                break;
+            }
+
+            for (int pointer2 = pointer1; pointer2 <= segments.stops; pointer2++) {
+                Segment carried = concatenate(vehicle, concatenate(vehicle, picked, segments.between(pointer1, pointer2)), delivery);
+                if (carried.timeWarp > 0) {
+                    break;
+                }
+
+                Segment route = concatenate(vehicle, carried, segments.between(pointer2, segments.stops));
+                int delta = removalDelta + route.cost - current.costs[vehicleIndex-1];
+                if (isSegmentFeasible(vehicle, route) && delta < bestDelta) {
+                    bestDelta = delta;
+                    bestVehicle = vehicleIndex;
+                    bestIndices = std::make_pair(pointer1, pointer2+1);
+                }
+            }
+        }
+    }
+
+    // Move the call to the best position found, if any
+    if (bestVehicle != 0) {
+        current.move(bestVehicle, callIndex, bestIndices);
+        current.updateFeasibility(sourceVehicle);
+        current.updateFeasibility(bestVehicle);
+    }
+
+    // Return the neighbour solution
+    return current;
+}
+
+Solution SwapCalls::apply(Solution* solution, int iteration, Xoshiro256& rng) {
+    // Release all scratch memory of the route segments when done
+    ArenaScope scope;
+
+    // Create a copy of the current solution
+    Solution current = solution->copy();
+    current.getCost();
+
+    // Pick a random call carried by one of our vehicles
+    ScratchVector<int> carriedCalls;
+    for (int callIndex = 1; callIndex <= current.problem->noCalls; callIndex++) {
+        if (current.callDetails[callIndex-1].vehicle != current.outsourceVehicle) {
+            carriedCalls.push_back(callIndex);
+        }
+    }
+    if (carriedCalls.empty()) {
+        return current;
+    }
+    int callIndex = carriedCalls[std::uniform_int_distribution<int>(0, carriedCalls.size()-1)(rng)];
+    auto [vehicleIndex, indices, removed] = current.callDetails[callIndex-1];
+    Vehicle& vehicle = current.problem->vehicles[vehicleIndex-1];
+    RouteSegments segments(vehicleIndex, current.representation[vehicleIndex-1], &current);
+
+    // Lambda evaluating a route where one call takes over the positions of another
+    auto replaced = [&](Vehicle& vehicle, RouteSegments& segments, std::pair<int, int> indices, int callIndex) {
+        Segment route = concatenate(vehicle, segments.prefix(indices.first), stopSegment(vehicle, current.problem, callIndex, true));
+        route = concatenate(vehicle, route, segments.between(indices.first+1, indices.second));
+        route = concatenate(vehicle, route, stopSegment(vehicle, current.problem, callIndex, false));
+        return concatenate(vehicle, route, segments.between(indices.second+1, segments.stops));
+    };
+
+    // Find the cheapest exchange with a call in any other vehicle, where both vehicles are compatible with the other's call
+    std::unordered_set<int>& possibleVehicles = current.problem->calls[callIndex-1].possibleVehiclesSet;
+    int bestDelta = INT_MAX, bestCall = 0;
+    for (int otherVehicle = 1; otherVehicle <= current.problem->noVehicles; otherVehicle++) {
+        if (otherVehicle == vehicleIndex || current.representation[otherVehicle-1].empty() || possibleVehicles.find(otherVehicle) == possibleVehicles.end()) {
+            continue;
+        }
+
+        Vehicle& other = current.problem->vehicles[otherVehicle-1];
+        RouteSegments otherSegments(otherVehicle, current.representation[otherVehicle-1], &current);
+        for (int i = 0; i < otherSegments.stops; i++) {
+            int otherCall = current.representation[otherVehicle-1][i];
+            std::pair<int, int> otherIndices = current.callDetails[otherCall-1].indices;
+            if (otherIndices.first != i || vehicle.possibleCallsSet.find(otherCall) == vehicle.possibleCallsSet.end()) {
+                continue;
+            }
+
+            Segment route = replaced(vehicle, segments, indices, otherCall);
+            Segment otherRoute = replaced(other, otherSegments, otherIndices, callIndex);
+            int delta = route.cost + otherRoute.cost - current.costs[vehicleIndex-1] - current.costs[otherVehicle-1];
+            if (isSegmentFeasible(vehicle, route) && isSegmentFeasible(other, otherRoute) && delta < bestDelta) {
+                bestDelta = delta;
+                bestCall = otherCall;
+            }
+        }
+    }
+
+    // Exchange the calls, each taking the positions of the other
+    if (bestCall != 0) {
+        auto [otherVehicle, otherIndices, otherRemoved] = current.callDetails[bestCall-1];
+        current.remove(callIndex);
+        current.remove(bestCall);
+        current.add(vehicleIndex, bestCall, indices);
+        current.add(otherVehicle, callIndex, otherIndices);
+        current.updateFeasibility(vehicleIndex);
+        current.updateFeasibility(otherVehicle);
+    }
+
+    // Return the neighbour solution
+    return current;
+}
+
+Solution CrossExchange::apply(Solution* solution, int iteration, Xoshiro256& rng) {
+    // Release all scratch memory of the route segments when done
+    ArenaScope scope;
+
+    // Create a copy of the current solution
+    Solution current = solution->copy();
+    current.getCost();
+
+    // Pick two random vehicles, of which at least one carries something
+    if (current.problem->noVehicles < 2) {
+        return current;
+    }
+    int vehicleA = std::uniform_int_distribution<int>(1, current.problem->noVehicles)(rng);
+    int vehicleB = std::uniform_int_distribution<int>(1, current.problem->noVehicles-1)(rng);
+    vehicleB += (vehicleB >= vehicleA);
+    std::vector<int>& routeA = current.representation[vehicleA-1];
+    std::vector<int>& routeB = current.representation[vehicleB-1];
+    if (routeA.empty() && routeB.empty()) {
+        return current;
+    }
+
+    // Summarize each route as driven by its own vehicle and by the other one
+    Vehicle& a = current.problem->vehicles[vehicleA-1];
+    Vehicle& b = current.problem->vehicles[vehicleB-1];
+    RouteSegments segmentsA(vehicleA, routeA, &current), segmentsAinB(vehicleB, routeA, &current);
+    RouteSegments segmentsB(vehicleB, routeB, &current), segmentsBinA(vehicleA, routeB, &current);
+
+    // Lambda finding which route ends only hold calls compatible with the other vehicle
+    auto compatibleEnds = [&](std::vector<int>& route, Vehicle& other) {
+        ScratchVector<char> compatible(route.size()+1, true);
+        for (int i = route.size()-1; i >= 0; i--) {
+            compatible[i] = compatible[i+1] && other.possibleCallsSet.find(route[i]) != other.possibleCallsSet.end();
+        }
+        return compatible;
+    };
+    ScratchVector<char> compatibleA = compatibleEnds(routeA, b), compatibleB = compatibleEnds(routeB, a);
+
+    // Try every pair of cuts where both vehicles are empty, exchanging what comes after
+    int bestDelta = INT_MAX, bestCutA = -1, bestCutB = -1;
+    for (int cutA = 0; cutA <= segmentsA.stops; cutA++) {
+        if (segmentsA.between(0, cutA).load != 0 || !compatibleA[cutA]) {
+            continue;
+        }
+        for (int cutB = 0; cutB <= segmentsB.stops; cutB++) {
+            if (segmentsB.between(0, cutB).load != 0 || !compatibleB[cutB] || (cutA == segmentsA.stops && cutB == segmentsB.stops)) {
+                continue;
+            }
+
+            Segment newA = concatenate(a, segmentsA.prefix(cutA), segmentsBinA.between(cutB, segmentsB.stops));
+            Segment newB = concatenate(b, segmentsB.prefix(cutB), segmentsAinB.between(cutA, segmentsA.stops));
+            int delta = newA.cost + newB.cost - current.costs[vehicleA-1] - current.costs[vehicleB-1];
+            if (isSegmentFeasible(a, newA) && isSegmentFeasible(b, newB) && delta < bestDelta) {
+                bestDelta = delta;
+                bestCutA = cutA;
+                bestCutB = cutB;
+            }
+        }
+    }
+
+    // Exchange the route ends after the best cuts
+    if (bestCutA != -1) {
+        std::vector<int> newA(routeA.begin(), routeA.begin() + bestCutA), newB(routeB.begin(), routeB.begin() + bestCutB);
+        newA.insert(newA.end(), routeB.begin() + bestCutB, routeB.end());
+        newB.insert(newB.end(), routeA.begin() + bestCutA, routeA.end());
+        current.replaceRoute(vehicleA, newA);
+        current.replaceRoute(vehicleB, newB);
+    }
+
+    // Return the neighbour solution
+    return current;
+}
+
+Solution LocalSearch::apply(Solution* solution, int iteration, Xoshiro256& rng) {
+    // Create a copy of the current solution, and descend to a local optimum
+    Solution current = solution->copy();
+    if (current.isFeasible()) {
+        LocalOptimizer(&current).run();
+    }
+
+    // Return the neighbour solution
+    return current;
+}
+
+PartitionRepair::PartitionRepair(int partitions) {
+    this->partitions = partitions;
+}
+
+Solution PartitionRepair::apply(Solution* solution, int iteration, Xoshiro256& rng) {
+    Problem* problem = solution->problem;
+    int noPartitions = std::min(this->partitions, problem->noVehicles);
+
+    // Fill the caches of the solution up front, as the partitions only read it
+    solution->getCost();
+    solution->isFeasible();
+
+    // Cluster the vehicles around random seed vehicles, by the travel time between their home nodes
+    std::vector<int> seeds(problem->noVehicles);
+    std::iota(seeds.begin(), seeds.end(), 1);
+    std::shuffle(seeds.begin(), seeds.end(), rng);
+    seeds.resize(noPartitions);
+
+    std::vector<int> partitionOf(problem->noVehicles, -1);
+    for (int k = 0; k < noPartitions; k++) {
+        partitionOf[seeds[k]-1] = k;
+    }
+    std::vector<std::vector<int>> partitionVehicles(noPartitions);
+    for (int vehicleIndex = 1; vehicleIndex <= problem->noVehicles; vehicleIndex++) {
+        // Seeds already form their own partition, others join the closest seed
+        Vehicle& vehicle = problem->vehicles[vehicleIndex-1];
+        if (partitionOf[vehicleIndex-1] == -1) {
+            int closest = INT_MAX;
+            for (int k = 0; k < noPartitions; k++) {
+                int time = vehicle.routeTimeCost[vehicle.homeNode-1][problem->vehicles[seeds[k]-1].homeNode-1].time;
+                if (time < closest) {
+                    closest = time;
+                    partitionOf[vehicleIndex-1] = k;
+                }
+            }
+        }
+        partitionVehicles[partitionOf[vehicleIndex-1]].push_back(vehicleIndex);
+    }
+
+    // Calls belong to the partition of their vehicle, outsourced calls to that of a random compatible vehicle
+    std::vector<std::vector<int>> partitionCalls(noPartitions);
+    for (int callIndex = 1; callIndex <= problem->noCalls; callIndex++) {
+        int vehicleIndex = solution->callDetails[callIndex-1].vehicle;
+        if (vehicleIndex == solution->outsourceVehicle) {
+            std::vector<int>& possibleVehicles = problem->calls[callIndex-1].possibleVehicles;
+            if (possibleVehicles.empty()) {
+                continue;
+            }
+            vehicleIndex = possibleVehicles[std::uniform_int_distribution<int>(0, possibleVehicles.size()-1)(rng)];
+        }
+        partitionCalls[partitionOf[vehicleIndex-1]].push_back(callIndex);
+    }
+
+    // Spread the calls to remove over the partitions by their size, and seed a random number generator per partition
+    int callsToRemove = boundedUniformSample(solution, iteration, rng);
+    std::vector<int> partitionRemovals(noPartitions);
+    std::vector<Xoshiro256> rngs;
+    for (int k = 0; k < noPartitions; k++) {
+        int share = std::round((double)callsToRemove * partitionCalls[k].size() / problem->noCalls);
+        partitionRemovals[k] = std::min((int)partitionCalls[k].size(), std::max(1, share));
+        rngs.push_back(rng.split());
+    }
+
+    // Destroy and repair every partition concurrently, each on a copy which may only insert into the partition's vehicles
+    std::vector<std::optional<Solution>> repaired(noPartitions);
+    ThreadPool::shared().parallelFor(0, noPartitions, [&](int k) {
+        // Release all scratch memory of the heuristics when done
+        ArenaScope scope;
+
+        Solution current = solution->copy();
+        current.ownedVehicles.assign(problem->noVehicles, false);
+        for (int vehicleIndex : partitionVehicles[k]) {
+            current.ownedVehicles[vehicleIndex-1] = true;
+        }
+
+        // Remove random calls of the partition, and insert them using greedy
+        ScratchVector<int> removedCalls;
+        std::sample(partitionCalls[k].begin(), partitionCalls[k].end(), std::back_inserter(removedCalls), partitionRemovals[k], rngs[k]);
+        for (int callIndex : removedCalls) {
+            current.remove(callIndex);
+        }
+        insertGreedy(removedCalls, &current);
+
+        repaired[k] = std::move(current);
+    });
+
+    // Find the partitions to merge, which are those which did not get worse, or the least worse one if all did
+    std::vector<int> deltas(noPartitions);
+    int leastWorse = 0;
+    for (int k = 0; k < noPartitions; k++) {
+        deltas[k] = repaired[k]->getCost() - solution->getCost();
+        if (deltas[k] < deltas[leastWorse]) {
+            leastWorse = k;
+        }
+    }
+
+    // Merge them into a single neighbour, as partitions share neither vehicles nor calls
+    Solution current = solution->copy();
+    for (int k = 0; k < noPartitions; k++) {
+        if (deltas[k] > 0 && k != leastWorse) {
+            continue;
+        }
+
+        // First move the partition's calls into or out of outsourcing, then take over the routes of its vehicles
+        Solution& partition = *repaired[k];
+        for (int callIndex : partitionCalls[k]) {
+            bool outsourced = partition.callDetails[callIndex-1].vehicle == partition.outsourceVehicle;
+            bool wasOutsourced = current.callDetails[callIndex-1].vehicle == current.outsourceVehicle;
+            if (outsourced && !wasOutsourced) {
+                current.outsource(callIndex);
+            } else if (!outsourced && wasOutsourced) {
+                current.remove(callIndex);
+            }
+        }
+        for (int vehicleIndex : partitionVehicles[k]) {
+            current.replaceRoute(vehicleIndex, partition.representation[vehicleIndex-1]);
+        }
+    }
+    current.updateFeasibility(current.outsourceVehicle);
+
+    // Return the neighbour solution
+    return current;
+}
+
+// Calls last sampled on each thread, for the adaptive operator's cost model
+static thread_local int sampledCalls = 0;
+
+int boundedUniformSample(Solution* solution, int iteration, Xoshiro256& rng) {
     int lowerbound = std::uniform_int_distribution<int>(1, std::max(1, solution->problem->noCalls / 10))(rng);
     int upperbound = std::max(lowerbound, (solution->problem->noCalls < 200) ? solution->problem->noCalls / 2 : solution->problem->noCalls / 4);
-    return std::uniform_int_distribution<int>(lowerbound, upperbound)(rng);
+    sampledCalls = std::uniform_int_distribution<int>(lowerbound, upperbound)(rng);
+    return sampledCalls;
+}
+
+int takeSampledCalls() {
+    int calls = sampledCalls;
+    sampledCalls = 0;
+    return calls;
 }
\ No newline at end of file
@@ -1,8 +1,12 @@
 #include "parser.h"
 
+bool Parser::granularNeighbourhoods = false;
+
 Problem Parser::parseProblem(std::string path) {
-    // Create a problem instance
+    // Create a problem instance, with empty route caches
     Problem problem = Problem();
+    problem.routeCache = std::make_shared<RouteCache>(ROUTE_CACHE_CAPACITY, ROUTE_CACHE_SHARDS);
+    problem.sequenceCache = std::make_shared<SequenceCache>(SEQUENCE_CACHE_CAPACITY);
 
     // Read from the given data file
     std::string line;
@@ -177,6 +181,97 @@ Problem Parser::parseProblem(std::string path) {
         std::cerr << "ERROR: Couldn't open data file '" << path << "'" << std::endl;
     }
 
+    // Find how much each vehicle's costs violate the triangle inequality (due to rounding),
+    // which bounds how much cheaper a route can get by visiting an extra node
+    for (Vehicle& vehicle : problem.vehicles) {
+        vehicle.triangleSlack = 0;
+        for (int node1 = 0; node1 < problem.noNodes; node1++) {
+            for (int node2 = 0; node2 < problem.noNodes; node2++) {
+                for (int node3 = 0; node3 < problem.noNodes; node3++) {
+                    int shortcut = vehicle.routeTimeCost[node1][node3].cost - vehicle.routeTimeCost[node1][node2].cost - vehicle.routeTimeCost[node2][node3].cost;
+                    vehicle.triangleSlack = std::max(vehicle.triangleSlack, shortcut);
+                }
+            }
+        }
+    }
+
+    // Precompute the outcome of inserting each call into an empty vehicle, which only depends on static data:
+    // the route home -> origin -> destination, its feasibility and cost
+    for (Vehicle& vehicle : problem.vehicles) {
+        vehicle.emptyRoutes.assign(problem.noCalls, {false, 0});
+        for (int callIndex : vehicle.possibleCalls) {
+            Call& call = problem.calls[callIndex-1];
+            TimeCost& toOrigin = vehicle.routeTimeCost[vehicle.homeNode-1][call.originNode-1];
+            TimeCost& toDestination = vehicle.routeTimeCost[call.originNode-1][call.destinationNode-1];
+
+            // Travel to origin, wait if early and pickup, then travel to destination
+            int pickupTime = vehicle.startTime + toOrigin.time;
+            int deliveryTime = std::max(pickupTime, call.pickupWindow.start) + vehicle.callTimeCost[callIndex-1].first.time + toDestination.time;
+
+            EmptyRoute& emptyRoute = vehicle.emptyRoutes[callIndex-1];
+            emptyRoute.feasible = vehicle.capacity >= call.size && pickupTime <= call.pickupWindow.end && deliveryTime <= call.deliveryWindow.end;
+            emptyRoute.cost = toOrigin.cost + toDestination.cost + vehicle.callTimeCost[callIndex-1].first.cost + vehicle.callTimeCost[callIndex-1].second.cost;
+        }
+    }
+
+    // Find which vehicles can never exceed their capacity, as the calls they are compatible with can't be
+    // carried at the same time in large enough numbers. Calls can only be carried together if the intervals
+    // from their earliest pickup to their latest delivery overlap, so sweep over these intervals to find the largest load
+    for (Vehicle& vehicle : problem.vehicles) {
+        std::vector<std::pair<int, int>> events;
+        for (int callIndex : vehicle.possibleCalls) {
+            Call& call = problem.calls[callIndex-1];
+            events.push_back(std::make_pair(call.pickupWindow.start, call.size));
+            events.push_back(std::make_pair(call.deliveryWindow.end, -call.size));
+        }
+
+        // Pickups are sorted before deliveries at the same time, as both are inclusive
+        std::sort(events.begin(), events.end(), [](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+            return a.first < b.first || (a.first == b.first && a.second > b.second);
+        });
+
+        int load = 0, maxLoad = 0;
+        for (auto && [time, size] : events) {
+            load += size;
+            maxLoad = std::max(maxLoad, load);
+        }
+        vehicle.capacityUnconstrained = vehicle.capacity >= maxLoad;
+    }
+
+    // Group interchangeable vehicles, which share home node, start time, capacity, compatible calls and all travel
+    // and service times and costs, into classes named after their first vehicle
+    for (int vehicleIndex = 1; vehicleIndex <= problem.noVehicles; vehicleIndex++) {
+        Vehicle& vehicle = problem.vehicles[vehicleIndex-1];
+        vehicle.equivalenceClass = vehicleIndex;
+        for (int otherIndex = 1; otherIndex < vehicleIndex; otherIndex++) {
+            Vehicle& other = problem.vehicles[otherIndex-1];
+            if (other.equivalenceClass == otherIndex && vehicle.homeNode == other.homeNode && vehicle.startTime == other.startTime &&
+                vehicle.capacity == other.capacity && vehicle.possibleCallsSet == other.possibleCallsSet) {
+                bool equivalent = true;
+                for (int callIndex : vehicle.possibleCalls) {
+                    std::pair<TimeCost, TimeCost>& a = vehicle.callTimeCost[callIndex-1], & b = other.callTimeCost[callIndex-1];
+                    if (a.first.time != b.first.time || a.first.cost != b.first.cost || a.second.time != b.second.time || a.second.cost != b.second.cost) {
+                        equivalent = false;
+                        break;
+                    }
+                }
+                for (int node1 = 0; node1 < problem.noNodes && equivalent; node1++) {
+                    for (int node2 = 0; node2 < problem.noNodes; node2++) {
+                        TimeCost& a = vehicle.routeTimeCost[node1][node2], & b = other.routeTimeCost[node1][node2];
+                        if (a.time != b.time || a.cost != b.cost) {
+                            equivalent = false;
+                            break;
+                        }
+                    }
+                }
+                if (equivalent) {
+                    vehicle.equivalenceClass = otherIndex;
+                    break;
+                }
+            }
+        }
+    }
+
     // Lambda to easily average distance between calls over all vehicles
     auto calculateMeanDistance = [problem](int node1, int node2) {
         double distance = 0;
@@ -218,6 +313,33 @@ Problem Parser::parseProblem(std::string path) {
         });
     }
 
+    // If enabled, decide the granular neighbourhood size, growing slowly with the instance size
+    int neighbours = std::max(10, (int)std::ceil(2.0 * std::sqrt(problem.noCalls)));
+    problem.granularity = (Parser::granularNeighbourhoods && neighbours < problem.noCalls-1) ? neighbours : 0;
+
+    // Then store the most related calls and nearest stops for each call
+    for (int callIndex = 1; callIndex <= problem.noCalls && problem.granularity > 0; callIndex++) {
+        Call& call = problem.calls[callIndex-1];
+        call.relatedCalls.resize(problem.noCalls);
+
+        std::vector<double> originDistances, destinationDistances;
+        for (int i = 0; i < problem.granularity; i++) {
+            Call& otherCall = problem.calls[call.similarities[i].callIndex-1];
+            call.relatedCalls[call.similarities[i].callIndex-1] = true;
+
+            originDistances.push_back(calculateMeanDistance(call.originNode, otherCall.originNode));
+            originDistances.push_back(calculateMeanDistance(call.originNode, otherCall.destinationNode));
+            destinationDistances.push_back(calculateMeanDistance(call.destinationNode, otherCall.originNode));
+            destinationDistances.push_back(calculateMeanDistance(call.destinationNode, otherCall.destinationNode));
+        }
+
+        // Stops closer than the granularity-th nearest related stop are considered near
+        std::nth_element(originDistances.begin(), originDistances.begin() + problem.granularity-1, originDistances.end());
+        std::nth_element(destinationDistances.begin(), destinationDistances.begin() + problem.granularity-1, destinationDistances.end());
+        call.originRadius = (int)originDistances[problem.granularity-1];
+        call.destinationRadius = (int)destinationDistances[problem.granularity-1];
+    }
+
     // Return the problem instance
     return problem;
 }
\ No newline at end of file
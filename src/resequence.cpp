@@ -0,0 +1,133 @@
+#include "resequence.h"
+
+int sequenceCalls(Problem* problem, Vehicle& vehicle, std::vector<int>& calls, std::vector<int>& route) {
+    int noCalls = calls.size();
+
+    // Stops are numbered 2i for the pickup and 2i+1 for the delivery of the i-th call
+    auto stopNode = [&](int stop) {
+        Call& call = problem->calls[calls[stop / 2]-1];
+        return (stop % 2 == 0) ? call.originNode : call.destinationNode;
+    };
+    auto stateKey = [](SequenceLabel& label) {
+        return ((label.picked << RESEQUENCE_MAX_CALLS) + label.delivered) * (2 * RESEQUENCE_MAX_CALLS + 1) + label.last + 1;
+    };
+
+    // Start at home, then extend every label by one stop per step
+    ScratchVector<SequenceLabel> labels;
+    labels.push_back({0, vehicle.startTime, 0, 0, -1, -1});
+    ScratchVector<int> layer(1, 0), next;
+    for (int step = 0; step < 2 * noCalls; step++) {
+        next.clear();
+        for (int labelIndex : layer) {
+            SequenceLabel label = labels[labelIndex];
+            int node = (label.last == -1) ? vehicle.homeNode : stopNode(label.last);
+
+            int load = 0;
+            for (int i = 0; i < noCalls; i++) {
+                if ((label.picked & ~label.delivered) & (1 << i)) {
+                    load += problem->calls[calls[i]-1].size;
+                }
+            }
+
+            for (int i = 0; i < noCalls; i++) {
+                int bit = 1 << i;
+                bool pickup = !(label.picked & bit);
+                if (!pickup && (label.delivered & bit)) {
+                    continue;
+                }
+
+                Call& call = problem->calls[calls[i]-1];
+                if (pickup && load + call.size > vehicle.capacity) {
+                    continue;
+                }
+
+                // Travel to the stop, which has to be reached within its time window, waiting if early
+                Interval& window = pickup ? call.pickupWindow : call.deliveryWindow;
+                TimeCost& leg = vehicle.routeTimeCost[node-1][stopNode(2*i + !pickup)-1];
+                int arrival = label.time + leg.time;
+                if (arrival > window.end) {
+                    continue;
+                }
+
+                TimeCost& service = pickup ? vehicle.callTimeCost[calls[i]-1].first : vehicle.callTimeCost[calls[i]-1].second;
+                labels.push_back({label.cost + leg.cost + service.cost, std::max(arrival, window.start) + service.time, label.picked | bit, label.delivered | (pickup ? 0 : bit), 2*i + !pickup, labelIndex});
+                next.push_back(labels.size()-1);
+            }
+        }
+
+        // Only keep labels which aren't both more expensive and later than another one of the same state
+        std::sort(next.begin(), next.end(), [&](int a, int b) {
+            int keyA = stateKey(labels[a]), keyB = stateKey(labels[b]);
+            if (keyA != keyB) {
+                return keyA < keyB;
+            }
+            return std::make_pair(labels[a].cost, labels[a].time) < std::make_pair(labels[b].cost, labels[b].time);
+        });
+        layer.clear();
+        int previousKey = -1, earliestTime = INT_MAX;
+        for (int labelIndex : next) {
+            SequenceLabel& label = labels[labelIndex];
+            if (stateKey(label) != previousKey) {
+                previousKey = stateKey(label);
+                earliestTime = INT_MAX;
+            }
+            if (label.time < earliestTime) {
+                earliestTime = label.time;
+                layer.push_back(labelIndex);
+            }
+        }
+    }
+
+    // Every label left has visited all stops, so take the cheapest and follow it back to the start
+    if (layer.empty()) {
+        return INT_MAX;
+    }
+    int best = *std::min_element(layer.begin(), layer.end(), [&](int a, int b) {
+        return labels[a].cost < labels[b].cost;
+    });
+
+    route.clear();
+    for (int labelIndex = best; labels[labelIndex].parent != -1; labelIndex = labels[labelIndex].parent) {
+        route.push_back(calls[labels[labelIndex].last / 2]);
+    }
+    std::reverse(route.begin(), route.end());
+    return labels[best].cost;
+}
+
+bool resequenceRoute(int vehicleIndex, Solution* solution) {
+    std::vector<int>& representation = solution->representation[vehicleIndex-1];
+    int noCalls = representation.size() / 2;
+    if (noCalls < 2 || noCalls > RESEQUENCE_MAX_CALLS) {
+        return false;
+    }
+
+    // The sorted calls of the route identify it in the cache
+    std::vector<int> calls(representation);
+    std::sort(calls.begin(), calls.end());
+    calls.erase(std::unique(calls.begin(), calls.end()), calls.end());
+
+    Vehicle& vehicle = solution->problem->vehicles[vehicleIndex-1];
+    std::vector<int> route;
+    int cost;
+    if (!solution->problem->sequenceCache->lookup(vehicle.equivalenceClass, calls, route, cost)) {
+        ArenaScope scope;
+        cost = sequenceCalls(solution->problem, vehicle, calls, route);
+        solution->problem->sequenceCache->store(vehicle.equivalenceClass, calls, route, cost);
+    }
+
+    // Only replace the route if strictly cheaper
+    solution->getCost();
+    if (cost >= solution->costs[vehicleIndex-1]) {
+        return false;
+    }
+    solution->replaceRoute(vehicleIndex, route);
+    return true;
+}
+
+int resequenceRoutes(Solution* solution) {
+    int improved = 0;
+    for (int vehicleIndex = 1; vehicleIndex <= solution->problem->noVehicles; vehicleIndex++) {
+        improved += resequenceRoute(vehicleIndex, solution);
+    }
+    return improved;
+}
@@ -0,0 +1,117 @@
+#include "rng.h"
+
+static inline std::uint64_t rotate(std::uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+Xoshiro256::Xoshiro256(std::uint64_t seed) {
+    // Spread the seed over the whole state, which may never be all zeroes
+    for (std::uint64_t& word : this->state) {
+        seed += 0x9E3779B97F4A7C15ULL;
+        std::uint64_t z = seed;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        word = z ^ (z >> 31);
+    }
+}
+
+Xoshiro256::result_type Xoshiro256::operator()() {
+    std::uint64_t result = rotate(this->state[1] * 5, 7) * 9;
+    std::uint64_t t = this->state[1] << 17;
+
+    this->state[2] ^= this->state[0];
+    this->state[3] ^= this->state[1];
+    this->state[1] ^= this->state[2];
+    this->state[0] ^= this->state[3];
+    this->state[2] ^= t;
+    this->state[3] = rotate(this->state[3], 45);
+
+    return result;
+}
+
+void Xoshiro256::jump() {
+    static const std::uint64_t polynomial[4] = {0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL, 0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL};
+    this->jump(polynomial);
+}
+
+void Xoshiro256::longJump() {
+    static const std::uint64_t polynomial[4] = {0x76E15D3EFEFDCBBFULL, 0xC5004E441C522FB3ULL, 0x77710069854EE241ULL, 0x39109BB02ACBE635ULL};
+    this->jump(polynomial);
+}
+
+Xoshiro256 Xoshiro256::split() {
+    Xoshiro256 stream = *this;
+    this->jump();
+    return stream;
+}
+
+void Xoshiro256::jump(const std::uint64_t (&polynomial)[4]) {
+    // Sum up the states at every power of two set in the polynomial
+    std::uint64_t jumped[4] = {0, 0, 0, 0};
+    for (std::uint64_t word : polynomial) {
+        for (int bit = 0; bit < 64; bit++) {
+            if (word & (1ULL << bit)) {
+                for (int i = 0; i < 4; i++) {
+                    jumped[i] ^= this->state[i];
+                }
+            }
+            (*this)();
+        }
+    }
+
+    for (int i = 0; i < 4; i++) {
+        this->state[i] = jumped[i];
+    }
+}
+
+void AliasTable::build(const std::vector<double>& weights) {
+    int n = weights.size();
+    this->probabilities.assign(n, 1.0);
+    this->aliases.resize(n);
+    for (int i = 0; i < n; i++) {
+        this->aliases[i] = i;
+    }
+
+    double sum = 0;
+    for (double weight : weights) {
+        sum += weight;
+    }
+
+    // Scale the weights to an average of one, and split them into those below and above it
+    std::vector<double> scaled(n);
+    std::vector<int> small, large;
+    for (int i = 0; i < n; i++) {
+        scaled[i] = weights[i] * n / sum;
+        (scaled[i] < 1.0 ? small : large).push_back(i);
+    }
+
+    // Fill up every small column with the remainder of a large one
+    while (!small.empty() && !large.empty()) {
+        int less = small.back(), more = large.back();
+        small.pop_back();
+
+        this->probabilities[less] = scaled[less];
+        this->aliases[less] = more;
+        scaled[more] -= 1.0 - scaled[less];
+        if (scaled[more] < 1.0) {
+            large.pop_back();
+            small.push_back(more);
+        }
+    }
+
+    // Columns left over are full, up to rounding errors
+    for (int i : small) {
+        this->probabilities[i] = 1.0;
+    }
+    for (int i : large) {
+        this->probabilities[i] = 1.0;
+    }
+}
+
+int AliasTable::sample(Xoshiro256& rng) {
+    // Pick a column uniformly from the high 32 bits, and its own index or alias from the low 32 bits
+    std::uint64_t random = rng();
+    int column = ((random >> 32) * this->probabilities.size()) >> 32;
+    double coin = (random & 0xFFFFFFFFULL) * (1.0 / 4294967296.0);
+    return (coin < this->probabilities[column]) ? column : this->aliases[column];
+}
@@ -0,0 +1,121 @@
+#include "routecache.h"
+
+RouteCache::RouteCache(int capacity, int shards) : hitCount(0), missCount(0) {
+    this->noShards = shards;
+    this->shardCapacity = std::max(1, capacity / shards);
+    this->shards = std::make_unique<RouteCacheShard[]>(shards);
+}
+
+unsigned long long RouteCache::key(int vehicleClass, std::vector<int>& route) {
+    // Polynomial hash over the stops, finished by a multiply-xorshift so nearby routes spread over all shards
+    unsigned long long hash = 0x9E3779B97F4A7C15ULL * (vehicleClass + 1);
+    for (int callIndex : route) {
+        hash = (hash + callIndex) * 0x100000001B3ULL;
+    }
+    hash ^= hash >> 29;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+bool RouteCache::lookup(unsigned long long key, int vehicleClass, std::vector<int>& route, RouteEvaluation& evaluation) {
+    RouteCacheShard& shard = this->shards[key % this->noShards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto found = shard.index.find(key);
+    if (found == shard.index.end() || found->second->vehicleClass != vehicleClass || found->second->route != route) {
+        this->missCount++;
+        return false;
+    }
+    this->hitCount++;
+
+    // Mark the route as most recently used
+    shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+    evaluation = found->second->evaluation;
+    return true;
+}
+
+void RouteCache::store(unsigned long long key, int vehicleClass, std::vector<int>& route, RouteEvaluation& evaluation) {
+    RouteCacheShard& shard = this->shards[key % this->noShards];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    // Overwrite the entry of the key if it exists (a colliding route is simply replaced)
+    auto found = shard.index.find(key);
+    if (found != shard.index.end()) {
+        std::list<RouteCacheEntry>::iterator entry = found->second;
+        entry->vehicleClass = vehicleClass;
+        entry->route.assign(route.begin(), route.end());
+        entry->evaluation = evaluation;
+        shard.entries.splice(shard.entries.begin(), shard.entries, entry);
+        return;
+    }
+
+    if (shard.entries.size() < this->shardCapacity) {
+        shard.entries.push_front({key, vehicleClass, route, evaluation});
+        shard.index[key] = shard.entries.begin();
+        return;
+    }
+
+    // When full, reuse the least recently used entry (and its index node) for the new route, without allocating
+    std::list<RouteCacheEntry>::iterator entry = std::prev(shard.entries.end());
+    auto node = shard.index.extract(entry->key);
+    node.key() = key;
+    shard.index.insert(std::move(node));
+
+    entry->key = key;
+    entry->vehicleClass = vehicleClass;
+    entry->route.assign(route.begin(), route.end());
+    entry->evaluation = evaluation;
+    shard.entries.splice(shard.entries.begin(), shard.entries, entry);
+}
+
+long long RouteCache::hits() {
+    return this->hitCount;
+}
+
+long long RouteCache::misses() {
+    return this->missCount;
+}
+
+double RouteCache::hitRate() {
+    long long lookups = this->hitCount + this->missCount;
+    return (lookups == 0) ? 0 : (double)this->hitCount / lookups;
+}
+
+SequenceCache::SequenceCache(int capacity) : hitCount(0), missCount(0) {
+    this->capacity = capacity;
+}
+
+bool SequenceCache::lookup(int vehicleClass, std::vector<int>& calls, std::vector<int>& route, int& cost) {
+    unsigned long long key = RouteCache::key(vehicleClass, calls);
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    auto found = this->entries.find(key);
+    if (found == this->entries.end() || found->second.vehicleClass != vehicleClass || found->second.calls != calls) {
+        this->missCount++;
+        return false;
+    }
+    this->hitCount++;
+
+    route = found->second.route;
+    cost = found->second.cost;
+    return true;
+}
+
+void SequenceCache::store(int vehicleClass, std::vector<int>& calls, std::vector<int>& route, int cost) {
+    unsigned long long key = RouteCache::key(vehicleClass, calls);
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    if (this->entries.size() >= this->capacity) {
+        this->entries.clear();
+    }
+    this->entries[key] = {vehicleClass, calls, route, cost};
+}
+
+long long SequenceCache::hits() {
+    return this->hitCount;
+}
+
+long long SequenceCache::misses() {
+    return this->missCount;
+}
@@ -0,0 +1,164 @@
+#include "scheduler.h"
+
+std::vector<Job> Scheduler::parseArguments(int argc, char const *argv[], int& experiments, TerminationCriteria& criteria) {
+    std::vector<Job> jobs;
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+
+        if (argument == "--experiments" && i+1 < argc) {
+            experiments = std::max(1, std::atoi(argv[++i]));
+        } else if (argument == "--stagnation" && i+1 < argc) {
+            criteria.maxStagnation = std::max(0, std::atoi(argv[++i]));
+        } else if (argument == "--improvement" && i+2 < argc) {
+            criteria.minimumImprovement = std::max(0.0, std::atof(argv[++i]));
+            criteria.window = std::max(0, std::atoi(argv[++i]));
+        } else if (argument == "--granular") {
+            Parser::granularNeighbourhoods = true;
+        } else if (argument == "--jobs" && i+1 < argc) {
+            // Read a job from every line of the file
+            std::string path = argv[++i];
+            std::ifstream file(path);
+            if (!file.is_open()) {
+                std::cerr << "ERROR: Couldn't open job file '" << path << "'" << std::endl;
+                continue;
+            }
+
+            std::string line;
+            while (std::getline(file, line)) {
+                Job job;
+                if (line.empty() || line[0] == '#') {
+                    continue;
+                }
+                if (Scheduler::parseJob(line, ' ', job)) {
+                    jobs.push_back(job);
+                }
+            }
+        } else {
+            Job job;
+            if (Scheduler::parseJob(argument, ':', job)) {
+                jobs.push_back(job);
+            }
+        }
+    }
+    return jobs;
+}
+
+bool Scheduler::parseJob(std::string description, char separator, Job& job) {
+    // Split into instance, algorithm, seed, minutes and target
+    std::vector<std::string> fields;
+    std::stringstream stream(description);
+    std::string field;
+    while (std::getline(stream, field, separator)) {
+        if (!field.empty()) {
+            fields.push_back(field);
+        }
+    }
+
+    if ((fields.size() != 4 && fields.size() != 5) || (fields[1] != "final" && fields[1] != "batch" && fields[1] != "island" && fields[1] != "bandit" && fields[1] != "tempering")) {
+        std::cerr << "ERROR: Couldn't parse job '" << description << "'" << std::endl;
+        return false;
+    }
+    try {
+        job = {fields[0], fields[1], (unsigned int)std::stoul(fields[2]), std::stod(fields[3]), (fields.size() == 5) ? std::stoi(fields[4]) : 0};
+    } catch (std::logic_error& error) {
+        std::cerr << "ERROR: Couldn't parse seed, minutes or target of job '" << description << "'" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::vector<AlgorithmInformation> Scheduler::run(std::vector<Job>& jobs, int experiments, TerminationCriteria criteria) {
+    // Run every experiment as its own task, such that experiments of the same job run in parallel aswell,
+    // sharing the cores through a controller that stops converged experiments and gives their cores to improving ones.
+    // Experiments run on the shared pool, alongside the tasks within them, so there is never more than a thread per core.
+    // A worker running an experiment only helps with its own parallel loops, so it never gets stuck in another experiment
+    int cores = ThreadPool::shared().size() + 1;
+    BudgetController budget(cores);
+    std::vector<std::optional<AlgorithmInformation>> outputs(jobs.size() * experiments);
+    ThreadPool::shared().parallelFor(0, jobs.size() * experiments, [&](int task) {
+        outputs[task] = Scheduler::runExperiment(jobs[task / experiments], task % experiments, budget, criteria);
+    });
+    Debugger::printToTerminal("Stopped " + std::to_string(budget.stoppedEarly()) + " experiments on convergence, saving " + Debugger::formatDouble(budget.savedSeconds(), 1) + " seconds of their time\n");
+
+    // Then merge the experiments of each job, in the order the jobs were given
+    std::vector<AlgorithmInformation> informations;
+    for (int i = 0; i < jobs.size(); i++) {
+        std::vector<AlgorithmInformation> jobOutputs;
+        for (int e = 0; e < experiments; e++) {
+            jobOutputs.push_back(std::move(*outputs[i * experiments + e]));
+        }
+        informations.push_back(Scheduler::merge(jobOutputs));
+    }
+    return informations;
+}
+
+std::vector<Operator*> Scheduler::createOperators() {
+    return {
+        new SimilarGreedyInsert(),
+        new SimilarRegretInsert(),
+        new CostlyGreedyInsert(),
+        new CostlyRegretInsert(),
+        new RandomGreedyInsert(),
+        new RandomRegretInsert(),
+        new RelocateCall(),
+        new SwapCalls(),
+        new CrossExchange(),
+        new LocalSearch(),
+        new PartitionRepair(4),
+    };
+}
+
+Operator* Scheduler::createOperator() {
+    return new AdaptiveOperator(Scheduler::createOperators(), true);
+}
+
+AlgorithmInformation Scheduler::runExperiment(Job& job, int experiment, BudgetController& budget, TerminationCriteria criteria) {
+    // Every experiment of a job gets its own stream, 2^192 numbers apart
+    Xoshiro256 rng(job.seed);
+    for (int e = 0; e < experiment; e++) {
+        rng.longJump();
+    }
+
+    // Stop at the target of the job, if any
+    criteria.target = job.target;
+
+    // Parallel algorithms use a neighbour or island per core
+    int cores = ThreadPool::shared().size() + 1;
+    if (job.algorithm == "island") {
+        return InstanceRunner::islandAdaptiveMetaheuristic(Scheduler::createOperator, job.instance, 1, job.time, cores, rng, 0, "", &budget, criteria);
+    }
+    if (job.algorithm == "tempering") {
+        return InstanceRunner::parallelTempering(Scheduler::createOperator, job.instance, 1, job.time, cores, rng, 0, "", &budget, criteria);
+    }
+
+    // The operator, along with its sub-operators, is freed with the experiment
+    if (job.algorithm == "bandit") {
+        std::unique_ptr<Operator> neighbourOperator(new BanditOperator(Scheduler::createOperators()));
+        return InstanceRunner::finalAdaptiveMetaheuristic(neighbourOperator.get(), job.instance, 1, job.time, rng, "Final Bandit Metaheuristic", 1, &budget, criteria);
+    }
+
+    std::unique_ptr<Operator> neighbourOperator(Scheduler::createOperator());
+    return InstanceRunner::finalAdaptiveMetaheuristic(neighbourOperator.get(), job.instance, 1, job.time, rng, "", (job.algorithm == "batch") ? cores : 1, &budget, criteria);
+}
+
+AlgorithmInformation Scheduler::merge(std::vector<AlgorithmInformation>& experiments) {
+    // Average the objective, runtime and hit rate, keep the best solution and all episodes
+    AlgorithmInformation information = experiments[0];
+    information.averageObjective = 0;
+    information.averageTime = 0;
+    information.routeCacheHitRate = 0;
+    information.episodes.clear();
+    for (AlgorithmInformation& experiment : experiments) {
+        information.averageObjective += experiment.averageObjective / experiments.size();
+        information.averageTime += experiment.averageTime / experiments.size();
+        information.routeCacheHitRate += experiment.routeCacheHitRate / experiments.size();
+        information.episodes.insert(information.episodes.end(), experiment.episodes.begin(), experiment.episodes.end());
+
+        // Every experiment starts from the same initial solution, so the best one also has the largest improvement
+        if (experiment.bestSolution.getCost() < information.bestSolution.getCost()) {
+            information.bestSolution = experiment.bestSolution;
+            information.improvement = experiment.improvement;
+        }
+    }
+    return information;
+}
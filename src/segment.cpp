@@ -0,0 +1,83 @@
+#include "segment.h"
+
+Segment emptySegment() {
+    return {true, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+}
+
+Segment startSegment(Vehicle& vehicle) {
+    return {false, vehicle.homeNode, vehicle.homeNode, 0, 0, vehicle.startTime, vehicle.startTime, 0, 0, 0};
+}
+
+Segment stopSegment(Vehicle& vehicle, Problem* problem, int callIndex, bool pickup) {
+    Call& call = problem->calls[callIndex-1];
+    int node = pickup ? call.originNode : call.destinationNode;
+    Interval& window = pickup ? call.pickupWindow : call.deliveryWindow;
+    TimeCost& service = pickup ? vehicle.callTimeCost[callIndex-1].first : vehicle.callTimeCost[callIndex-1].second;
+    int load = pickup ? call.size : -call.size;
+    return {false, node, node, service.time, 0, window.start, window.end, service.cost, load, std::max(load, 0)};
+}
+
+Segment concatenate(Vehicle& vehicle, Segment a, Segment b) {
+    if (a.empty) {
+        return b;
+    }
+    if (b.empty) {
+        return a;
+    }
+
+    // Travel between the segments, then wait if arriving before b can start, or warp back in time if after
+    TimeCost& travel = vehicle.routeTimeCost[a.lastNode-1][b.firstNode-1];
+    int delta = a.duration - a.timeWarp + travel.time;
+    int waiting = std::max(b.earliest - delta - a.latest, 0);
+    int warp = std::max(a.earliest + delta - b.latest, 0);
+
+    Segment segment;
+    segment.empty = false;
+    segment.firstNode = a.firstNode;
+    segment.lastNode = b.lastNode;
+    segment.duration = a.duration + b.duration + travel.time + waiting;
+    segment.timeWarp = a.timeWarp + b.timeWarp + warp;
+    segment.earliest = std::max(b.earliest - delta, a.earliest) - waiting;
+    segment.latest = std::min(b.latest - delta, a.latest) + warp;
+    segment.cost = a.cost + b.cost + travel.cost;
+    segment.load = a.load + b.load;
+    segment.peakLoad = std::max(a.peakLoad, a.load + b.peakLoad);
+    return segment;
+}
+
+bool isSegmentFeasible(Vehicle& vehicle, Segment& segment) {
+    return segment.timeWarp == 0 && segment.peakLoad <= vehicle.capacity;
+}
+
+RouteSegments::RouteSegments(int vehicleIndex, std::vector<int>& route, Solution* solution) {
+    Vehicle& vehicle = solution->problem->vehicles[vehicleIndex-1];
+    this->stops = route.size();
+
+    // The first occurence of a call is its pickup, found from the route itself as it need not be part of the solution
+    ScratchVector<Segment> stopSegments;
+    for (int i = 0; i < this->stops; i++) {
+        bool pickup = std::find(route.begin(), route.begin() + i, route[i]) == route.begin() + i;
+        stopSegments.push_back(stopSegment(vehicle, solution->problem, route[i], pickup));
+    }
+
+    // Extend every subsequence by one stop at a time, starting from the empty ones
+    this->table.resize((this->stops+1) * (this->stops+1), emptySegment());
+    for (int begin = 0; begin < this->stops; begin++) {
+        for (int end = begin+1; end <= this->stops; end++) {
+            this->between(begin, end) = concatenate(vehicle, this->between(begin, end-1), stopSegments[end-1]);
+        }
+    }
+
+    this->prefixes.resize(this->stops+1);
+    for (int end = 0; end <= this->stops; end++) {
+        this->prefixes[end] = concatenate(vehicle, startSegment(vehicle), this->between(0, end));
+    }
+}
+
+Segment& RouteSegments::between(int begin, int end) {
+    return this->table[begin * (this->stops+1) + end];
+}
+
+Segment& RouteSegments::prefix(int end) {
+    return this->prefixes[end];
+}
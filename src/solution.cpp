@@ -1,6 +1,10 @@
 #include "solution.h"
 
 #include "debug.h"
+#include "insertioncache.h"
+#include "routecache.h"
+
+std::atomic<long long> Solution::lastVersion(0);
 
 Solution::Solution(Problem* problem) {
     // Link problem to solution
@@ -9,6 +13,8 @@ Solution::Solution(Problem* problem) {
     // Reserve representation size
     this->representation.resize(problem->noVehicles+1);
     this->costs.resize(problem->noVehicles+1);
+    this->profiles.resize(problem->noVehicles+1);
+    this->versions.resize(problem->noVehicles+1);
 
     this->callDetails.resize(problem->noCalls);
 
@@ -26,6 +32,8 @@ Solution::Solution(std::vector<int> representation, Problem* problem) : outsourc
     // Reserve representation size
     this->representation.resize(problem->noVehicles+1);
     this->costs.resize(problem->noVehicles+1);
+    this->profiles.resize(problem->noVehicles+1);
+    this->versions.resize(problem->noVehicles+1);
 
     this->callDetails.resize(problem->noCalls);
 
@@ -51,6 +59,9 @@ Solution::Solution(std::vector<int> representation, Problem* problem) : outsourc
         this->representation[currentVehicle-1].push_back(callIndex);
     }
 
+    // Start a new insertion cache
+    this->insertionCache = std::make_shared<InsertionCache>(problem, INSERTION_CACHE_SHARDS);
+
     // Precompute feasibility
     this->isFeasible();
 
@@ -65,8 +76,14 @@ Solution Solution::copy() {
     // Copy over representation, seperator and cost vectors
     solution.representation = this->representation;
     solution.costs = this->costs;
+    solution.profiles = this->profiles;
     solution.callDetails = this->callDetails;
 
+    // Routes keep their versions, so the shared insertion cache and profiles stay valid for them
+    solution.versions = this->versions;
+    solution.insertionCache = this->insertionCache;
+    solution.ownedVehicles = this->ownedVehicles;
+
     // Copy over feasibility and cost
     solution.feasibilityCache = std::make_pair(true, this->isFeasible());
     solution.costCache = std::make_pair(true, this->getCost());
@@ -90,6 +107,9 @@ Solution Solution::initialSolution(Problem* problem) {
         solution.representation[vehicleIndex-1].push_back(callIndex);
     }
 
+    // Start a new insertion cache
+    solution.insertionCache = std::make_shared<InsertionCache>(problem, INSERTION_CACHE_SHARDS);
+
     // Set solution to feasible
     solution.isFeasible();
 
@@ -100,7 +120,7 @@ Solution Solution::initialSolution(Problem* problem) {
     return solution;
 }
 
-Solution Solution::randomSolution(Problem* problem, std::default_random_engine& rng) {
+Solution Solution::randomSolution(Problem* problem, Xoshiro256& rng) {
     // Create an empty initial solution
     Solution solution(problem);
 
@@ -125,8 +145,8 @@ Solution Solution::randomSolution(Problem* problem, std::default_random_engine&
         int currentIndex = solution.representation[vehicleIndex-1].size();
         solution.callDetails[callIndex-1] = {vehicleIndex, std::make_pair(currentIndex, currentIndex+1)};
 
-        solution.representation[solution.outsourceVehicle].push_back(callIndex);
-        solution.representation[solution.outsourceVehicle].push_back(callIndex);
+        solution.representation[vehicleIndex-1].push_back(callIndex);
+        solution.representation[vehicleIndex-1].push_back(callIndex);
     }
 
     // At last, shuffle all but outsource vehicle
@@ -147,6 +167,9 @@ Solution Solution::randomSolution(Problem* problem, std::default_random_engine&
         }
     }
 
+    // Start a new insertion cache
+    solution.insertionCache = std::make_shared<InsertionCache>(problem, INSERTION_CACHE_SHARDS);
+
     // Precalculate cost and feasibility
     solution.isFeasible();
     solution.getCost();
@@ -158,37 +181,34 @@ Solution Solution::randomSolution(Problem* problem, std::default_random_engine&
 void Solution::add(int vehicleIndex, int callIndex, std::pair<int, int> indices) {
     std::vector<int>& representation = this->representation[vehicleIndex-1];
 
-    // Resize the vector up
-    representation.resize(representation.size()+2);
+    // Shift the rest of the route to make room for the call, only allocating when the route outgrows its capacity
+    representation.insert(representation.begin() + indices.first, callIndex);
+    representation.insert(representation.begin() + indices.second, callIndex);
 
-    // Denote start of iteration
-    int start = indices.first;
-    
-    // Add call to representation
-    std::deque<int> buffer;
-    std::unordered_set<int> pickedCalls;
-    for (int i = start; i < representation.size(); i++) {
+    // Update any callDetails indices of shifted calls, going back to front so a call's pickup index
+    // is still the old one when its delivery is seen
+    auto shifted = [&indices](int index) {
+        return index + (index >= indices.first) + (index >= indices.second-1);
+    };
+    for (int i = representation.size()-1; i >= indices.first; i--) {
         if (i == indices.first || i == indices.second) {
-            buffer.push_back(representation[i]);
-            representation[i] = callIndex;
-        } else {
-            buffer.push_back(representation[i]);
-            representation[i] = buffer.front();
-            buffer.pop_front();
+            continue;
         }
 
-        // Update any callDetails indices
-        if (this->callDetails[representation[i]-1].indices.first >= start && pickedCalls.find(representation[i]) == pickedCalls.end()) {
-            this->callDetails[representation[i]-1].indices.first = i;
-            pickedCalls.insert(representation[i]);
+        CallDetails& details = this->callDetails[representation[i]-1];
+        if (shifted(details.indices.first) == i) {
+            details.indices.first = i;
         } else {
-            this->callDetails[representation[i]-1].indices.second = i;
+            details.indices.second = i;
         }
     }
 
     // Update callDetails for inserted call
     this->callDetails[callIndex-1] = {vehicleIndex, indices, false};
 
+    // The route changed, so it gets a new version, for which its profile has to be recomputed
+    this->versions[vehicleIndex-1] = ++Solution::lastVersion;
+
     // And then update the cost
     this->updateCost(callIndex, true);
 }
@@ -197,35 +217,29 @@ void Solution::remove(int callIndex) {
     int vehicleIndex = this->callDetails[callIndex-1].vehicle;
     std::vector<int>& representation = this->representation[vehicleIndex-1];
 
-    // Denote start of iteration
-    int start = this->callDetails[callIndex-1].indices.first;
-
     // Remove call from representation
-    int skip = 0;
-    std::unordered_set<int> pickedCalls;
-    for (int i = start; i+skip < representation.size(); i++) {
-        while (i+skip < representation.size() && representation[i+skip] == callIndex) {
-            skip++;
-        }
+    std::pair<int, int> indices = this->callDetails[callIndex-1].indices;
+    representation.erase(representation.begin() + indices.second);
+    representation.erase(representation.begin() + indices.first);
 
-        if (i+skip < representation.size()) {
-            representation[i] = representation[i+skip];
-            
-            // Update any callDetails indices
-            if (this->callDetails[representation[i]-1].indices.first >= start && pickedCalls.find(representation[i]) == pickedCalls.end()) {
-                this->callDetails[representation[i]-1].indices.first = i;
-                pickedCalls.insert(representation[i]);
-            } else {
-                this->callDetails[representation[i]-1].indices.second = i;
-            }
+    // Update any callDetails indices of shifted calls, going back to front as in add
+    auto shifted = [&indices](int index) {
+        return index - (index > indices.first) - (index > indices.second);
+    };
+    for (int i = representation.size()-1; i >= indices.first; i--) {
+        CallDetails& details = this->callDetails[representation[i]-1];
+        if (shifted(details.indices.first) == i) {
+            details.indices.first = i;
+        } else {
+            details.indices.second = i;
         }
     }
 
     // Set callDetail to removed
     this->callDetails[callIndex-1].removed = true;
 
-    // Resize the vector down
-    representation.resize(representation.size()-2);
+    // The route changed, so it gets a new version, for which its profile has to be recomputed
+    this->versions[vehicleIndex-1] = ++Solution::lastVersion;
 
     // And update the cost
     this->updateCost(callIndex, false);
@@ -239,6 +253,46 @@ void Solution::move(int vehicleIndex, int callIndex, std::pair<int, int> indices
     this->add(vehicleIndex, callIndex, indices);
 }
 
+void Solution::replaceRoute(int vehicleIndex, std::vector<int>& route) {
+    std::vector<int>& representation = this->representation[vehicleIndex-1];
+    representation.assign(route.begin(), route.end());
+
+    // Update callDetails, where the first occurence of a call is its pickup
+    for (int i = representation.size()-1; i >= 0; i--) {
+        this->callDetails[representation[i]-1] = {vehicleIndex, std::make_pair(i, i), false};
+    }
+    for (int i = 0; i < representation.size(); i++) {
+        if (this->callDetails[representation[i]-1].indices.first != i) {
+            this->callDetails[representation[i]-1].indices.second = i;
+        }
+    }
+
+    // The route changed, so it gets a new version, for which its profile has to be recomputed
+    this->versions[vehicleIndex-1] = ++Solution::lastVersion;
+
+    // Update the cost of the vehicle
+    if (this->costCache.first) {
+        Vehicle& vehicle = this->problem->vehicles[vehicleIndex-1];
+        int newCost = 0, currentNode = vehicle.homeNode;
+        for (int i = 0; i < representation.size(); i++) {
+            int callIndex = representation[i];
+            Call& call = this->problem->calls[callIndex-1];
+            if (this->callDetails[callIndex-1].indices.first == i) {
+                newCost += vehicle.routeTimeCost[currentNode-1][call.originNode-1].cost + vehicle.callTimeCost[callIndex-1].first.cost;
+                currentNode = call.originNode;
+            } else {
+                newCost += vehicle.routeTimeCost[currentNode-1][call.destinationNode-1].cost + vehicle.callTimeCost[callIndex-1].second.cost;
+                currentNode = call.destinationNode;
+            }
+        }
+        this->costCache.second += newCost - this->costs[vehicleIndex-1];
+        this->costs[vehicleIndex-1] = newCost;
+    }
+
+    // And its feasibility
+    this->updateFeasibility(vehicleIndex);
+}
+
 std::pair<int, int> Solution::outsource(int callIndex) {
     // First find insertion position
     int insertion = std::distance(this->representation[this->outsourceVehicle-1].begin(), std::lower_bound(this->representation[this->outsourceVehicle-1].begin(), this->representation[this->outsourceVehicle-1].end(), callIndex));
@@ -260,101 +314,169 @@ bool Solution::isFeasible() {
     // Handle our vehicles
     for (int vehicleIndex = 1; vehicleIndex <= this->problem->noVehicles; vehicleIndex++) {
         Vehicle& vehicle = this->problem->vehicles[vehicleIndex-1];
+        std::vector<int>& route = this->representation[vehicleIndex-1];
+        if (route.empty()) {
+            continue;
+        }
 
-        std::unordered_set<int> startedCalls;
-        std::unordered_set<int>& possibleCalls = vehicle.possibleCallsSet;
+        // Consult the route cache before simulating
+        unsigned long long key = RouteCache::key(vehicle.equivalenceClass, route);
+        RouteEvaluation evaluation;
+        if (!this->problem->routeCache->lookup(key, vehicle.equivalenceClass, route, evaluation)) {
+            // Choose once per vehicle whether its capacity has to be tracked
+            evaluation.failure = std::make_pair(-1, false);
+            evaluation.feasible = vehicle.capacityUnconstrained ? this->isRouteFeasible<false>(vehicleIndex, evaluation.endTime) : this->isRouteFeasible<true>(vehicleIndex, evaluation.endTime);
+
+            // Only feasible routes are stored from here, as the point of failure isn't known
+            if (evaluation.feasible && this->costCache.first) {
+                evaluation.cost = this->costs[vehicleIndex-1];
+                this->problem->routeCache->store(key, vehicle.equivalenceClass, route, evaluation);
+            }
+        }
 
-        int currentTime = vehicle.startTime;
-        int currentCapacity = vehicle.capacity;
-        int currentNode = vehicle.homeNode;
+        if (!evaluation.feasible) {
+            this->feasibilityCache = std::make_pair(true, false);
+            return this->feasibilityCache.second;
+        }
+    }
 
-        for (int callIndex : this->representation[vehicleIndex-1]) {
-            if (possibleCalls.find(callIndex) == possibleCalls.end()) {
-                // Vehicle incompatible with call
-                this->feasibilityCache = std::make_pair(true, false);
-                return this->feasibilityCache.second;
-            }
+    // The solution is feasible!
+    this->feasibilityCache = std::make_pair(true, true);
+    return this->feasibilityCache.second;
+}
 
-            if (startedCalls.find(callIndex) == startedCalls.end()) {
-                startedCalls.insert(callIndex);
-                // Pickup call cargo
-                Call& call = this->problem->calls[callIndex-1];
-                
-                // Travel to call origin node
-                currentTime += vehicle.routeTimeCost[currentNode-1][call.originNode-1].time;
-                currentNode = call.originNode;
+template<bool TrackCapacity>
+bool Solution::isRouteFeasible(int vehicleIndex, int& endTime) {
+    Vehicle& vehicle = this->problem->vehicles[vehicleIndex-1];
 
-                // Verify within time window for pickup (inclusive)
-                if (currentTime < call.pickupWindow.start) {
-                    // Wait if arrived early
-                    currentTime = call.pickupWindow.start;
-                }
-                if (currentTime > call.pickupWindow.end) {
-                    // Arrived outside timewindow
-                    this->feasibilityCache = std::make_pair(true, false);
-                    return this->feasibilityCache.second;
-                }
+    // Mark started calls in a flat bitmap living in the thread-local arena
+    ArenaScope scope;
+    ScratchVector<bool> startedCalls(this->problem->noCalls, false);
+    std::unordered_set<int>& possibleCalls = vehicle.possibleCallsSet;
 
-                // Pickup cargo at origin node (wait some time)
-                currentTime += vehicle.callTimeCost[callIndex-1].first.time;
+    int currentTime = vehicle.startTime;
+    int currentCapacity = vehicle.capacity;
+    int currentNode = vehicle.homeNode;
+
+    for (int callIndex : this->representation[vehicleIndex-1]) {
+        if (possibleCalls.find(callIndex) == possibleCalls.end()) {
+            // Vehicle incompatible with call
+            return false;
+        }
+
+        if (!startedCalls[callIndex-1]) {
+            startedCalls[callIndex-1] = true;
+            // Pickup call cargo
+            Call& call = this->problem->calls[callIndex-1];
+            
+            // Travel to call origin node
+            currentTime += vehicle.routeTimeCost[currentNode-1][call.originNode-1].time;
+            currentNode = call.originNode;
+
+            // Verify within time window for pickup (inclusive)
+            if (currentTime < call.pickupWindow.start) {
+                // Wait if arrived early
+                currentTime = call.pickupWindow.start;
+            }
+            if (currentTime > call.pickupWindow.end) {
+                // Arrived outside timewindow
+                return false;
+            }
+
+            // Pickup cargo at origin node (wait some time)
+            currentTime += vehicle.callTimeCost[callIndex-1].first.time;
+            if constexpr (TrackCapacity) {
                 currentCapacity -= call.size;
 
                 // Verify capacity is not exceeded
                 if (currentCapacity < 0) {
                     // Capacity exceeded
-                    this->feasibilityCache = std::make_pair(true, false);
-                    return this->feasibilityCache.second;
+                    return false;
                 }
-                
-            } else {
-                // Deliver call cargo
-                Call& call = this->problem->calls[callIndex-1];
+            }
+        } else {
+            // Deliver call cargo
+            Call& call = this->problem->calls[callIndex-1];
 
-                // Travel to call destination node
-                currentTime += vehicle.routeTimeCost[currentNode-1][call.destinationNode-1].time;
-                currentNode = call.destinationNode;
+            // Travel to call destination node
+            currentTime += vehicle.routeTimeCost[currentNode-1][call.destinationNode-1].time;
+            currentNode = call.destinationNode;
 
-                // Verify within time window for delivery (inclusive)
-                if (currentTime < call.deliveryWindow.start) {
-                    // Wait if arrived early
-                    currentTime = call.deliveryWindow.start;
-                }
-                if (currentTime > call.deliveryWindow.end) {
-                    // Arrived outside timewindow
-                    this->feasibilityCache = std::make_pair(true, false);
-                    return this->feasibilityCache.second;
-                }
+            // Verify within time window for delivery (inclusive)
+            if (currentTime < call.deliveryWindow.start) {
+                // Wait if arrived early
+                currentTime = call.deliveryWindow.start;
+            }
+            if (currentTime > call.deliveryWindow.end) {
+                // Arrived outside timewindow
+                return false;
+            }
 
-                // Deliver cargo at destination node (wait some time)
-                currentTime += vehicle.callTimeCost[callIndex-1].second.time;
+            // Deliver cargo at destination node (wait some time)
+            currentTime += vehicle.callTimeCost[callIndex-1].second.time;
+            if constexpr (TrackCapacity) {
                 currentCapacity += call.size;
             }
         }
+    }
 
-        // Verify that all picked up calls were delivered (Only validity check as it is efficient to compute)
+    // Verify that all picked up calls were delivered (Only validity check as it is efficient to compute)
+    if constexpr (TrackCapacity) {
         assert(currentCapacity == vehicle.capacity);
     }
 
-    // The solution is feasible!
-    this->feasibilityCache = std::make_pair(true, true);
-    return this->feasibilityCache.second;
+    endTime = currentTime;
+    return true;
 }
 
 std::pair<int, bool> Solution::updateFeasibility(int vehicleIndex, int startIndex, int startTime, int startCapacity) {
-    // Initialize feasibility information
-    std::pair<int, bool> feasibilityInformation = std::make_pair(-1, false);
-
     // Early return as outsource is always feasible
     if (vehicleIndex == this->problem->noVehicles+1) {
         this->feasibilityCache = std::make_pair(true, true);
-        return feasibilityInformation;
-    }  
+        return std::make_pair(-1, false);
+    }
+
+    // An empty route is always feasible
+    Vehicle& vehicle = this->problem->vehicles[vehicleIndex-1];
+    std::vector<int>& route = this->representation[vehicleIndex-1];
+    if (route.empty()) {
+        this->feasibilityCache = std::make_pair(true, true);
+        return std::make_pair(-1, false);
+    }
+
+    // Consult the route cache before simulating
+    unsigned long long key = RouteCache::key(vehicle.equivalenceClass, route);
+    RouteEvaluation evaluation;
+    if (this->problem->routeCache->lookup(key, vehicle.equivalenceClass, route, evaluation)) {
+        this->feasibilityCache = std::make_pair(true, evaluation.feasible);
+        return evaluation.failure;
+    }
+
+    // Choose once whether the vehicle's capacity has to be tracked
+    evaluation.endTime = -1;
+    if (vehicle.capacityUnconstrained) {
+        evaluation.failure = this->updateRouteFeasibility<false>(vehicleIndex, startIndex, startTime, startCapacity, evaluation.endTime);
+    } else {
+        evaluation.failure = this->updateRouteFeasibility<true>(vehicleIndex, startIndex, startTime, startCapacity, evaluation.endTime);
+    }
+
+    if (this->costCache.first) {
+        evaluation.feasible = this->feasibilityCache.second;
+        evaluation.cost = this->costs[vehicleIndex-1];
+        this->problem->routeCache->store(key, vehicle.equivalenceClass, route, evaluation);
+    }
+    return evaluation.failure;
+}
+
+template<bool TrackCapacity>
+std::pair<int, bool> Solution::updateRouteFeasibility(int vehicleIndex, int startIndex, int startTime, int startCapacity, int& endTime) {
+    // Initialize feasibility information
+    std::pair<int, bool> feasibilityInformation = std::make_pair(-1, false);
 
     Vehicle& vehicle = this->problem->vehicles[vehicleIndex-1];
     std::unordered_set<int>& possibleCalls = vehicle.possibleCallsSet;
 
     std::vector<int>& representation = this->representation[vehicleIndex-1];
-    std::unordered_set<int> startedCalls;
 
     int currentTime = startTime == -1 ? vehicle.startTime : startTime;
     int currentCapacity = startCapacity == -1 ? vehicle.capacity : startCapacity;
@@ -378,8 +500,7 @@ std::pair<int, bool> Solution::updateFeasibility(int vehicleIndex, int startInde
         //    return feasibilityInformation;
         //}
 
-        if (this->callDetails[callIndex-1].indices.first >= startIndex && startedCalls.find(callIndex) == startedCalls.end()) {
-            startedCalls.insert(callIndex);
+        if (this->callDetails[callIndex-1].indices.first == i) {
             // Pickup call cargo
             Call& call = this->problem->calls[callIndex-1];
                 
@@ -401,17 +522,18 @@ std::pair<int, bool> Solution::updateFeasibility(int vehicleIndex, int startInde
 
             // Pickup cargo at origin node (wait some time)
             currentTime += vehicle.callTimeCost[callIndex-1].first.time;
-            currentCapacity -= call.size;
+            if constexpr (TrackCapacity) {
+                currentCapacity -= call.size;
 
-            // Verify capacity is not exceeded
-            if (currentCapacity < 0) {
-                // Capacity exceeded
-                this->feasibilityCache = std::make_pair(true, false);
-                feasibilityInformation.first = i;
-                feasibilityInformation.second = true;
-                return feasibilityInformation;
+                // Verify capacity is not exceeded
+                if (currentCapacity < 0) {
+                    // Capacity exceeded
+                    this->feasibilityCache = std::make_pair(true, false);
+                    feasibilityInformation.first = i;
+                    feasibilityInformation.second = true;
+                    return feasibilityInformation;
+                }
             }
-            
         } else {
             // Deliver call cargo
             Call& call = this->problem->calls[callIndex-1];
@@ -434,19 +556,24 @@ std::pair<int, bool> Solution::updateFeasibility(int vehicleIndex, int startInde
 
             // Deliver cargo at destination node (wait some time)
             currentTime += vehicle.callTimeCost[callIndex-1].second.time;
-            currentCapacity += call.size;
+            if constexpr (TrackCapacity) {
+                currentCapacity += call.size;
+            }
         }
     }
 
     // Verify that all picked up calls were delivered (Only validity check as it is efficient to compute)
-    if (currentCapacity != vehicle.capacity) {
-        std::cout << "Invalid solution!" << std::endl;
-        Debugger::printSolution(this);
-        assert(false);
+    if constexpr (TrackCapacity) {
+        if (currentCapacity != vehicle.capacity) {
+            std::cout << "Invalid solution!" << std::endl;
+            Debugger::printSolution(this);
+            assert(false);
+        }
     }
 
     // The solution is feasible!
     this->feasibilityCache = std::make_pair(true, true);
+    endTime = currentTime;
     return feasibilityInformation;
 }
 
@@ -456,6 +583,10 @@ int Solution::getCost() {
         return this->costCache.second;
     }
 
+    // Mark started and outsourced calls in flat bitmaps living in the thread-local arena
+    ArenaScope scope;
+    ScratchVector<bool> startedCalls(this->problem->noCalls, false);
+
     // Handle our vehicles
     int totalCost = 0;
     for (int vehicleIndex = 1; vehicleIndex <= this->problem->noVehicles; vehicleIndex++) {
@@ -463,12 +594,19 @@ int Solution::getCost() {
         this->costs[vehicleIndex-1] = 0;
 
         Vehicle& vehicle = this->problem->vehicles[vehicleIndex-1];
+        std::vector<int>& route = this->representation[vehicleIndex-1];
 
-        int currentNode = vehicle.homeNode;
-        std::unordered_set<int> startedCalls;
+        // Consult the route cache before summing up the route
+        RouteEvaluation evaluation;
+        if (!route.empty() && this->problem->routeCache->lookup(RouteCache::key(vehicle.equivalenceClass, route), vehicle.equivalenceClass, route, evaluation)) {
+            this->costs[vehicleIndex-1] = evaluation.cost;
+            totalCost += evaluation.cost;
+            continue;
+        }
 
+        int currentNode = vehicle.homeNode;
         for (int callIndex : this->representation[vehicleIndex-1]) {
-            if (startedCalls.find(callIndex) == startedCalls.end()) {
+            if (!startedCalls[callIndex-1]) {
                 // Pickup call cargo
                 Call& call = this->problem->calls[callIndex-1];
 
@@ -479,7 +617,7 @@ int Solution::getCost() {
                 // Pickup cargo at origin node (wait some time)
                 this->costs[vehicleIndex-1] += vehicle.callTimeCost[callIndex-1].first.cost;
 
-                startedCalls.insert(callIndex);
+                startedCalls[callIndex-1] = true;
             } else {
                 // Deliver call cargo
                 Call& call = this->problem->calls[callIndex-1];
@@ -497,17 +635,17 @@ int Solution::getCost() {
 
 
     // Handle outsourced calls
-    std::unordered_set<int> outsourcedCalls;
+    ScratchVector<bool> outsourcedCalls(this->problem->noCalls, false);
     this->costs[this->outsourceVehicle-1] = 0;
     for (int callIndex : this->representation[this->outsourceVehicle-1]) {
 
         // Only count outsourced calls once (for effiency)
-        if (outsourcedCalls.find(callIndex) == outsourcedCalls.end()) {
+        if (!outsourcedCalls[callIndex-1]) {
             // Outsource the call
             Call& call = this->problem->calls[callIndex-1];
             this->costs[this->outsourceVehicle-1] += call.costOfNotTransporting;
 
-            outsourcedCalls.insert(callIndex);
+            outsourcedCalls[callIndex-1] = true;
         }
     }
     totalCost += this->costs[this->outsourceVehicle-1];
@@ -674,8 +812,84 @@ std::pair<std::vector<int>, std::vector<int>> Solution::getDetails(int vehicleIn
     return std::make_pair(times, capacities);
 }
 
+RouteProfile& Solution::getProfile(int vehicleIndex) {
+    std::shared_ptr<RouteProfile>& shared = this->profiles[vehicleIndex-1];
+
+    // Only recompute if the route changed
+    if (shared && shared->version == this->versions[vehicleIndex-1]) {
+        return *shared;
+    }
+
+    // Recompute in place, unless copies still share the profile of their (older) route
+    if (!shared || shared.use_count() > 1) {
+        shared = std::make_shared<RouteProfile>();
+    }
+    RouteProfile& profile = *shared;
+
+    Vehicle& vehicle = this->problem->vehicles[vehicleIndex-1];
+    std::vector<int>& representation = this->representation[vehicleIndex-1];
+    int stops = representation.size();
+
+    profile.times.resize(stops+1);
+    profile.capacities.resize(stops+1);
+    profile.nodes.resize(stops);
+    profile.legTimes.resize(stops+1);
+    profile.legCosts.resize(stops+1);
+    profile.slack.resize(stops+1);
+    profile.waiting.resize(stops+1);
+
+    profile.times[0] = vehicle.startTime;
+    profile.capacities[0] = vehicle.capacity;
+
+    // Simulate the route forwards to get departure times and capacities
+    int currentNode = vehicle.homeNode;
+    for (int i = 0; i < stops; i++) {
+        int callIndex = representation[i];
+        Call& call = this->problem->calls[callIndex-1];
+        bool pickup = this->callDetails[callIndex-1].indices.first == i;
+
+        profile.nodes[i] = pickup ? call.originNode : call.destinationNode;
+        profile.legTimes[i] = vehicle.routeTimeCost[currentNode-1][profile.nodes[i]-1].time;
+        profile.legCosts[i] = vehicle.routeTimeCost[currentNode-1][profile.nodes[i]-1].cost;
+        currentNode = profile.nodes[i];
+
+        // Travel to the stop, waiting if arrived early, and then service it
+        Interval& window = pickup ? call.pickupWindow : call.deliveryWindow;
+        int currentTime = std::max(profile.times[i] + profile.legTimes[i], window.start);
+        profile.times[i+1] = currentTime + (pickup ? vehicle.callTimeCost[callIndex-1].first.time : vehicle.callTimeCost[callIndex-1].second.time);
+        profile.capacities[i+1] = profile.capacities[i] + (pickup ? -call.size : call.size);
+    }
+
+    // Then go backwards to find how much each arrival can be delayed,
+    // a delay is absorbed by waiting before it is passed on to the next stop
+    profile.legTimes[stops] = 0;
+    profile.legCosts[stops] = 0;
+    profile.slack[stops] = INT_MAX / 4;
+    profile.waiting[stops] = 0;
+    for (int i = stops-1; i >= 0; i--) {
+        int callIndex = representation[i];
+        Call& call = this->problem->calls[callIndex-1];
+        bool pickup = this->callDetails[callIndex-1].indices.first == i;
+
+        Interval& window = pickup ? call.pickupWindow : call.deliveryWindow;
+        int arrival = profile.times[i] + profile.legTimes[i];
+        profile.waiting[i] = std::max(window.start - arrival, 0);
+        profile.slack[i] = std::min(window.end - arrival, profile.waiting[i] + profile.slack[i+1]);
+    }
+
+    profile.version = this->versions[vehicleIndex-1];
+    return profile;
+}
+
+bool Solution::ownsVehicle(int vehicleIndex) {
+    return this->ownedVehicles.empty() || this->ownedVehicles[vehicleIndex-1];
+}
 
 void Solution::invalidateCache() {
     this->feasibilityCache.first = false;
     this->costCache.first = false;
+
+    for (std::shared_ptr<RouteProfile>& profile : this->profiles) {
+        profile.reset();
+    }
 }
\ No newline at end of file
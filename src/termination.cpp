@@ -0,0 +1,51 @@
+#include "termination.h"
+
+Termination::Termination(TerminationCriteria criteria, double deadline, Timer* timer) {
+    this->criteria = criteria;
+    this->criteria.clockInterval = std::max(1, criteria.clockInterval);
+    this->deadline = deadline;
+    this->timer = timer;
+}
+
+bool Termination::done(int iteration, int bestCost, int lastImprovement) {
+    // Read the clock every few iterations only
+    if (this->clockRead < 0 || iteration - this->clockRead >= this->criteria.clockInterval) {
+        this->clockRead = iteration;
+        this->lastElapsed = this->timer->check();
+        if (this->lastElapsed >= this->deadline) {
+            this->stoppedOn = "deadline";
+            return true;
+        }
+    }
+
+    // Stop once the target objective is reached
+    if (this->criteria.target > 0 && bestCost <= this->criteria.target) {
+        this->stoppedOn = "target";
+        return true;
+    }
+
+    // or the best solution has not been improved for too long
+    if (this->criteria.maxStagnation > 0 && iteration - lastImprovement > this->criteria.maxStagnation) {
+        this->stoppedOn = "stagnation";
+        return true;
+    }
+
+    // or it improved too little over the last window
+    if (this->criteria.window > 0 && this->criteria.minimumImprovement > 0 && (this->windowStart < 0 || iteration - this->windowStart >= this->criteria.window)) {
+        if (this->windowStart >= 0 && (double)(this->windowCost - bestCost) / this->windowCost < this->criteria.minimumImprovement) {
+            this->stoppedOn = "improvement";
+            return true;
+        }
+        this->windowStart = iteration;
+        this->windowCost = bestCost;
+    }
+    return false;
+}
+
+double Termination::elapsed() {
+    return this->lastElapsed;
+}
+
+std::string Termination::reason() {
+    return this->stoppedOn;
+}
@@ -1,6 +1,6 @@
 #include "testcase.h"
 
-void InstanceRunner::testAlgorithm(std::function<void(Operator*, std::string, int, int, std::default_random_engine&, std::string)> algorithm, Operator* neighbourOperator, int experiments, int iterations, std::default_random_engine& rng, std::string title) {
+void InstanceRunner::testAlgorithm(std::function<void(Operator*, std::string, int, int, Xoshiro256&, std::string)> algorithm, Operator* neighbourOperator, int experiments, int iterations, Xoshiro256& rng, std::string title) {
     // Hide cursor from terminal
     Debugger::displayCursor(false);
     
@@ -16,7 +16,7 @@ void InstanceRunner::testAlgorithm(std::function<void(Operator*, std::string, in
     Debugger::displayCursor(true);
 }
 
-void InstanceRunner::blindRandomSearch(Operator* neighbourOperator, std::string instance, int experiments, int iterations, std::default_random_engine& rng, std::string title = "Blind Random Search") {
+void InstanceRunner::blindRandomSearch(Operator* neighbourOperator, std::string instance, int experiments, int iterations, Xoshiro256& rng, std::string title = "Blind Random Search") {
     // Parse the given test instance
     Problem problem = Parser::parseProblem("data/" + instance + ".txt");
     std::string algorithm  = title == "" ? "Blind Random Search" : title;
@@ -67,7 +67,7 @@ void InstanceRunner::blindRandomSearch(Operator* neighbourOperator, std::string
     Debugger::printResults(instance, algorithm, averageObjective, bestSolutionOverall.getCost(), improvement, averageTime, &bestSolutionOverall);
 }
 
-void InstanceRunner::localSearch(Operator* neighbourOperator, std::string instance, int experiments, int iterations, std::default_random_engine& rng, std::string title = "Local Search") {
+void InstanceRunner::localSearch(Operator* neighbourOperator, std::string instance, int experiments, int iterations, Xoshiro256& rng, std::string title = "Local Search") {
     // Parse the given test instance
     Problem problem = Parser::parseProblem("data/" + instance + ".txt");
     std::string algorithm  = title == "" ? "Local Search" : title;
@@ -119,7 +119,7 @@ void InstanceRunner::localSearch(Operator* neighbourOperator, std::string instan
     Debugger::printResults(instance, algorithm, averageObjective, bestSolutionOverall.getCost(), improvement, averageTime, &bestSolutionOverall);
 }
 
-void InstanceRunner::simulatedAnnealing(Operator* neighbourOperator, std::string instance, int experiments, int iterations, std::default_random_engine& rng, std::string title = "Simulated Annealing") {
+void InstanceRunner::simulatedAnnealing(Operator* neighbourOperator, std::string instance, int experiments, int iterations, Xoshiro256& rng, std::string title = "Simulated Annealing") {
     // Parse the given test instance
     Problem problem = Parser::parseProblem("data/" + instance + ".txt");
     std::string algorithm = title == "" ? "Simulated Annealing" : title;
@@ -233,7 +233,7 @@ void InstanceRunner::simulatedAnnealing(Operator* neighbourOperator, std::string
     Debugger::printResults(instance, algorithm, averageObjective, bestSolutionOverall.getCost(), improvement, averageTime, &bestSolutionOverall);
 }
 
-void InstanceRunner::generalAdaptiveMetaheuristic(Operator* neighbourOperator, std::string instance, int experiments, int iterations, std::default_random_engine& rng, std::string title) {
+void InstanceRunner::generalAdaptiveMetaheuristic(Operator* neighbourOperator, std::string instance, int experiments, int iterations, Xoshiro256& rng, std::string title) {
     // Parse the given test instance
     Problem problem = Parser::parseProblem("data/" + instance + ".txt");
     std::string algorithm = title == "" ? "General Adaptive Metaheuristic" : title;
@@ -327,16 +327,17 @@ void InstanceRunner::generalAdaptiveMetaheuristic(Operator* neighbourOperator, s
                     int upperbound = std::max(3, incumbent.problem->noCalls / 5);
                     int callsToRemove = std::uniform_int_distribution<int>(lowerbound, upperbound)(rng);
 
-                    // Random removal
-                    std::vector<int> removedCalls = removeRandom(callsToRemove, &incumbent, rng);
+                    // Random removal, releasing its scratch memory after every step
+                    ArenaScope scope;
+                    ScratchVector<int> removedCalls = removeRandom(callsToRemove, &incumbent, rng);
 
                     // Greedy insertion
-                    std::set<int> callIndices(removedCalls.begin(), removedCalls.end());
+                    std::sort(removedCalls.begin(), removedCalls.end());
                     // Tiny chance to insert random
                     if (random(rng) < 0.03) {
-                        insertRandom(callIndices, &incumbent, rng);
+                        insertRandom(removedCalls, &incumbent, rng);
                     } else {
-                        insertGreedy(callIndices, &incumbent);
+                        insertGreedy(removedCalls, &incumbent);
                     }
 
                     if (incumbent.getCost() < bestSolution.getCost()) {
@@ -410,7 +411,7 @@ void InstanceRunner::generalAdaptiveMetaheuristic(Operator* neighbourOperator, s
     Debugger::printResults(instance, algorithm, averageObjective, bestSolutionOverall.getCost(), improvement, averageTime, &bestSolutionOverall);
 }
 
-AlgorithmInformation InstanceRunner::finalAdaptiveMetaheuristic(Operator* neighbourOperator, std::string instance, int experiments, double time, std::default_random_engine& rng, std::string title) {
+AlgorithmInformation InstanceRunner::finalAdaptiveMetaheuristic(Operator* neighbourOperator, std::string instance, int experiments, double time, Xoshiro256& rng, std::string title, int batchSize, BudgetController* budget, TerminationCriteria criteria) {
     // Parse the given test instance
     Problem problem = Parser::parseProblem("data/" + instance + ".txt");
     std::string algorithm = title == "" ? "Final Adaptive Metaheuristic" : title;
@@ -431,95 +432,384 @@ AlgorithmInformation InstanceRunner::finalAdaptiveMetaheuristic(Operator* neighb
     double initialObjective = bestSolutionOverall.getCost();
     double averageObjective = 0;
 
-    double timefound = 0.0;
-    int iterfound = 0, escapeCondition = 7500;
     double dMultiplier = 1.0 / std::pow(problem.noCalls, 2.0 / 3.0);
 
-    // Declare uniform [0, 1) distribution
-    std::uniform_real_distribution<double> random(0, 1);
-
     // Run the experiments
     for (int i = 0; i < experiments; i++) {
         // Start timer
         timer.start();
 
-        // Initialize the initial solution as the "current best"
-        Solution bestSolution = Solution::initialSolution(&problem);
-        Solution incumbent = Solution::initialSolution(&problem);
+        // Initialize the initial solution as the "current best", with the incumbent sharing its insertion cache
+        Solution initial = Solution::initialSolution(&problem);
+        SearchState state = {initial, initial.copy(), neighbourOperator, rng, batchSize, 0, 0, 0, 0.0};
 
-        // Store last time new best is found
-        int lastBestFound = 0;
+        // Count the heap allocations per iteration after warming up
+        long long warmupAllocations = -1;
 
-        // Run iterations per experiment
+        // Register with the budget controller, if any
+        int slot = (budget != nullptr) ? budget->enroll(deadline) : -1;
+
+        // Run iterations per experiment, until the deadline or any other termination criterion
         int totalIterations = 0;
-        for (int j = 0; timer.check() < deadline; j++) {
+        Termination termination(criteria, deadline, &timer);
+        std::string stoppedOn;
+        for (int j = 0; !termination.done(j, state.bestSolution.getCost(), state.iterfound); j++) {
             totalIterations = j;
+            if (j == SCRATCH_WARMUP_ITERATIONS) {
+                warmupAllocations = HeapCounter::allocations();
+            }
 
-            // If long since successful modification of incumbant, run escape algorithm
-            if (j - lastBestFound >= escapeCondition) {
-                if (printEscapes) {
-                    Debugger::printToTerminal("Applying escape at iteration: " + std::to_string(j) + "\n");
+            // Report progress to the budget controller, stopping once converged and otherwise taking its share of the cores
+            double elapsed = termination.elapsed();
+            if (budget != nullptr && j % BUDGET_INTERVAL == 0) {
+                if (!budget->report(slot, state.bestSolution.getCost(), elapsed)) {
+                    stoppedOn = "convergence";
+                    break;
                 }
+                state.batchSize = std::min(batchSize, budget->share(slot));
+            }
 
-                // Copy incumbant to not make changes to best solution
-                if (random(rng) < 2.0 / incumbent.problem->noCalls) {
-                    incumbent = bestSolution.copy();
-                } else {
-                    incumbent = incumbent.copy();
+            // Let the operator weigh its choice by the time left
+            neighbourOperator->setDeadline((deadline - elapsed) / deadline, deadline - elapsed);
+            adaptiveIteration(state, (deadline - elapsed) / deadline, elapsed, dMultiplier, printEscapes);
+        }
+        if (budget != nullptr) {
+            budget->finish(slot, timer.check());
+        }
+        if (stoppedOn.empty()) {
+            stoppedOn = termination.reason();
+        }
+        rng = state.rng;
+        Solution& bestSolution = state.bestSolution;
+        Solution& incumbent = state.incumbent;
+        int iterfound = state.iterfound;
+        double timefound = state.timefound;
+
+        // Capture current time
+        timer.capture();
+
+        // At the end of the experiment, count the current best cost towards the average cost
+        averageObjective += (double)bestSolution.getCost() / experiments;
+        // and check if it is better than the current best overall solution
+        if (bestSolution.getCost() < bestSolutionOverall.getCost()) {
+            bestSolutionOverall = bestSolution;
+        }
+
+        // Store episode information
+        int greedyCost = bestSolution.getCost();
+        bestSolution.invalidateCache();
+        int actualCost = bestSolution.getCost();
+        double heapAllocations = (warmupAllocations == -1) ? -1 : (double)(HeapCounter::allocations() - warmupAllocations) / std::max(1, totalIterations - SCRATCH_WARMUP_ITERATIONS);
+        episodes.push_back({bestSolution, greedyCost, actualCost, iterfound, timefound, totalIterations, heapAllocations, incumbent.insertionCache->hits(), incumbent.insertionCache->misses(), stoppedOn});
+    }
+
+    // Calculate the improvement from the initial solution
+    double improvement = 100 * (initialObjective - bestSolutionOverall.getCost()) / initialObjective;
+
+    // Retrieve runtime from timer
+    double averageTime = timer.retrieve();
+
+    // Store and return algorithm information
+    AlgorithmInformation information = {instance, algorithm, averageObjective, bestSolutionOverall, improvement, averageTime, episodes, problem.routeCache->hitRate()};
+    return information;
+}
+
+AlgorithmInformation InstanceRunner::islandAdaptiveMetaheuristic(std::function<Operator*()> createOperator, std::string instance, int experiments, double time, int islands, Xoshiro256& rng, int iterations, std::string title, BudgetController* budget, TerminationCriteria criteria) {
+    // Parse the given test instance
+    Problem problem = Parser::parseProblem("data/" + instance + ".txt");
+    std::string algorithm = title == "" ? "Island Adaptive Metaheuristic (" + std::to_string(islands) + " islands)" : title;
+
+    // Store information about each episode
+    std::vector<EpisodeInformation> episodes;
+
+    // Create a timer object
+    Timer timer = Timer(algorithm + ": " + instance, experiments);
+
+    // Compute a timebased deadline in seconds
+    double deadline = time * 60;
+
+    Solution bestSolutionOverall = Solution::initialSolution(&problem);
+    double initialObjective = bestSolutionOverall.getCost();
+    double averageObjective = 0;
+    double dMultiplier = 1.0 / std::pow(problem.noCalls, 2.0 / 3.0);
+
+    // Run the experiments
+    for (int i = 0; i < experiments; i++) {
+        // Start timer
+        timer.start();
+
+        // Every island starts from the initial solution, with its own operator (freed with the experiment) and random number stream
+        std::vector<std::unique_ptr<Operator>> operators;
+        std::vector<SearchState> states;
+        for (int k = 0; k < islands; k++) {
+            Solution initial = Solution::initialSolution(&problem);
+            operators.emplace_back(createOperator());
+            states.push_back({initial, initial.copy(), operators.back().get(), rng.split(), 1, 0, 0, 0, 0.0});
+        }
+        EliteBoard board(islands);
+
+        // Count the heap allocations per iteration after warming up, including those of the workers running the epochs
+        long long warmupAllocations = -1;
+        int warmupIterations = 0;
+
+        // Register with the budget controller, if any
+        int slot = (budget != nullptr) ? budget->enroll(deadline) : -1;
+
+        // Run epochs of all islands in parallel, until the iterations or the time run out, or any other termination criterion holds
+        // (whose deadline is left out if bounded by iterations, so the search does not depend on timing)
+        int totalIterations = 0;
+        std::string stoppedOn = (iterations > 0) ? "iterations" : "deadline";
+        Termination termination(criteria, (iterations > 0) ? INFINITY : deadline, &timer);
+        while (iterations > 0 ? totalIterations < iterations : timer.check() < deadline) {
+            int epoch = (iterations > 0) ? std::min(MIGRATION_INTERVAL, iterations - totalIterations) : MIGRATION_INTERVAL;
+            ThreadPool::shared().parallelFor(0, islands, [&](int k) {
+                SearchState& state = states[k];
+                for (int j = 0; j < epoch; j++) {
+                    // Remaining budget follows the iterations if given, so the search does not depend on timing
+                    double elapsed = timer.check();
+                    double remaining = (iterations > 0) ? 1.0 - (double)state.iteration / iterations : (deadline - elapsed) / deadline;
+                    state.neighbourOperator->setDeadline(remaining, (iterations > 0) ? INFINITY : deadline - elapsed);
+                    adaptiveIteration(state, remaining, elapsed, dMultiplier, false);
                 }
+                board.publish(k, state.bestSolution);
+            });
+            totalIterations += epoch;
+            if (warmupAllocations == -1 && totalIterations >= SCRATCH_WARMUP_ITERATIONS) {
+                warmupAllocations = HeapCounter::allocations();
+                warmupIterations = totalIterations;
+            }
 
-                // Then perform many small steps with most diversifying operator
-                for (int k = 0; k < 25; k++) {
-                    int lowerbound = std::max(1, (int)std::floor(incumbent.problem->noCalls / 50.0));
-                    int upperbound = std::max(2, (int)std::ceil(incumbent.problem->noCalls / 15.0));
-                    int callsToRemove = std::uniform_int_distribution<int>(lowerbound, upperbound)(rng);
+            // Migrate along a ring, each island continuing from its predecessor's best if that is better than its incumbent
+            for (int k = 0; k < islands; k++) {
+                std::shared_ptr<Solution> immigrant = board.read((k + islands - 1) % islands);
+                if (immigrant->getCost() < states[k].incumbent.getCost()) {
+                    states[k].incumbent = immigrant->copy();
+                }
+            }
+
+            // Check the termination criteria on the best island, and when any island last found a new best
+            int bestCost = INT_MAX, lastImprovement = 0;
+            for (int k = 0; k < islands; k++) {
+                bestCost = std::min(bestCost, states[k].bestSolution.getCost());
+                lastImprovement = std::max(lastImprovement, states[k].iterfound);
+            }
+            if (termination.done(totalIterations, bestCost, lastImprovement)) {
+                stoppedOn = termination.reason();
+                break;
+            }
 
-                    // Random removal
-                    std::vector<int> removedCalls = removeRandom(callsToRemove, &incumbent, rng);
+            // Report the best island to the budget controller, stopping once converged
+            if (budget != nullptr) {
+                if (!budget->report(slot, bestCost, timer.check())) {
+                    stoppedOn = "convergence";
+                    break;
+                }
+            }
+        }
+        if (budget != nullptr) {
+            budget->finish(slot, timer.check());
+        }
 
-                    // Greedy insertion
-                    std::set<int> callIndices(removedCalls.begin(), removedCalls.end());
-                    // Tiny chance to insert random
-                    insertGreedy(callIndices, &incumbent);
+        // Capture current time
+        timer.capture();
 
-                    if (incumbent.getCost() < bestSolution.getCost()) {
-                        bestSolution = incumbent.copy();
-                        iterfound = j;
-                        timefound = timer.check();
-                        if (printEscapes) {
-                            Debugger::printToTerminal("Found new optimal during escape! Cost: " + std::to_string(incumbent.getCost()) + "\n");
-                        }
+        // The best island (lowest index on ties) gives the result of the experiment
+        int bestIsland = 0;
+        for (int k = 1; k < islands; k++) {
+            if (states[k].bestSolution.getCost() < states[bestIsland].bestSolution.getCost()) {
+                bestIsland = k;
+            }
+        }
+        Solution& bestSolution = states[bestIsland].bestSolution;
+
+        // At the end of the experiment, count the current best cost towards the average cost
+        averageObjective += (double)bestSolution.getCost() / experiments;
+        // and check if it is better than the current best overall solution
+        if (bestSolution.getCost() < bestSolutionOverall.getCost()) {
+            bestSolutionOverall = bestSolution;
+        }
+
+        // Sum up the insertion caches of all islands, which migrants share with their origin
+        std::unordered_set<InsertionCache*> insertionCaches;
+        long long insertionCacheHits = 0, insertionCacheMisses = 0;
+        for (SearchState& state : states) {
+            if (insertionCaches.insert(state.incumbent.insertionCache.get()).second) {
+                insertionCacheHits += state.incumbent.insertionCache->hits();
+                insertionCacheMisses += state.incumbent.insertionCache->misses();
+            }
+        }
+
+        // Store episode information
+        int greedyCost = bestSolution.getCost();
+        bestSolution.invalidateCache();
+        int actualCost = bestSolution.getCost();
+        double heapAllocations = (warmupAllocations == -1) ? -1 : (double)(HeapCounter::allocations() - warmupAllocations) / std::max(1, (totalIterations - warmupIterations) * islands);
+        episodes.push_back({bestSolution, greedyCost, actualCost, states[bestIsland].iterfound, states[bestIsland].timefound, totalIterations * islands, heapAllocations, insertionCacheHits, insertionCacheMisses, stoppedOn});
+    }
+
+    // Calculate the improvement from the initial solution
+    double improvement = 100 * (initialObjective - bestSolutionOverall.getCost()) / initialObjective;
+
+    // Retrieve runtime from timer
+    double averageTime = timer.retrieve();
+
+    // Store and return algorithm information
+    AlgorithmInformation information = {instance, algorithm, averageObjective, bestSolutionOverall, improvement, averageTime, episodes, problem.routeCache->hitRate()};
+    return information;
+}
+
+AlgorithmInformation InstanceRunner::parallelTempering(std::function<Operator*()> createOperator, std::string instance, int experiments, double time, int replicas, Xoshiro256& rng, int iterations, std::string title, BudgetController* budget, TerminationCriteria criteria) {
+    // Parse the given test instance
+    Problem problem = Parser::parseProblem("data/" + instance + ".txt");
+    replicas = std::max(2, replicas);
+    std::string algorithm = title == "" ? "Parallel Tempering (" + std::to_string(replicas) + " replicas)" : title;
+
+    // Store information about each episode
+    std::vector<EpisodeInformation> episodes;
+
+    // Create a timer object
+    Timer timer = Timer(algorithm + ": " + instance, experiments);
+
+    // Compute a timebased deadline in seconds
+    double deadline = time * 60;
+
+    Solution bestSolutionOverall = Solution::initialSolution(&problem);
+    double initialObjective = bestSolutionOverall.getCost();
+    double averageObjective = 0;
+
+    // Declare uniform [0, 1) distribution
+    std::uniform_real_distribution<double> random(0, 1);
+
+    // Run the experiments
+    for (int i = 0; i < experiments; i++) {
+        // Start timer
+        timer.start();
+
+        // Every replica starts from the initial solution, with its own operator (freed with the experiment) and random number stream
+        std::vector<std::unique_ptr<Operator>> operators;
+        std::vector<SearchState> states;
+        for (int k = 0; k < replicas; k++) {
+            Solution initial = Solution::initialSolution(&problem);
+            operators.emplace_back(createOperator());
+            states.push_back({initial, initial.copy(), operators.back().get(), rng.split(), 1, 0, 0, 0, 0.0});
+        }
+
+        // Warm up every replica, accepting worse neighbours with the hottest probability, and average how much worse they are
+        std::vector<double> deltaAverages(replicas, 0.0);
+        ThreadPool::shared().parallelFor(0, replicas, [&](int k) {
+            SearchState& state = states[k];
+            int updates = 1;
+            for (int w = 0; w < EXCHANGE_INTERVAL; w++) {
+                int j = state.iteration++;
+                Solution solution = state.neighbourOperator->apply(&state.incumbent, j, state.rng);
+                if (!solution.isFeasible()) {
+                    continue;
+                }
+
+                double deltaE = solution.getCost() - state.incumbent.getCost();
+                if (deltaE < 0) {
+                    state.incumbent = solution;
+                    if (state.incumbent.getCost() < state.bestSolution.getCost()) {
+                        state.bestSolution = state.incumbent;
+                        state.iterfound = j;
+                        state.timefound = timer.check();
                     }
+                } else {
+                    if (random(state.rng) < HOTTEST_ACCEPTANCE) {
+                        state.incumbent = solution;
+                    }
+                    deltaAverages[k] += (deltaE - deltaAverages[k]) / updates;
+                    updates++;
                 }
-                
-                lastBestFound = j;
             }
+        });
+        int totalIterations = EXCHANGE_INTERVAL;
+
+        // Spread the temperatures geometrically between the hottest and the coldest acceptance of an average worse neighbour, coldest first
+        double deltaAverage = std::max(1.0, std::accumulate(deltaAverages.begin(), deltaAverages.end(), 0.0) / replicas);
+        double hottest = -deltaAverage / std::log(HOTTEST_ACCEPTANCE);
+        double coldest = -deltaAverage / std::log(COLDEST_ACCEPTANCE);
+        std::vector<double> temperatures;
+        for (int k = 0; k < replicas; k++) {
+            temperatures.push_back(coldest * std::pow(hottest / coldest, (double)k / (replicas - 1)));
+        }
 
-            // Generate a new neighbour solution
-            Solution solution = neighbourOperator->apply(&incumbent, j, rng);
+        // Count the heap allocations per iteration after warming up, including those of the workers running the epochs
+        long long warmupAllocations = -1;
+        int warmupIterations = 0;
+
+        // Register with the budget controller, if any
+        int slot = (budget != nullptr) ? budget->enroll(deadline) : -1;
+
+        // Run epochs of all replicas in parallel, until the iterations or the time run out, or any other termination criterion holds
+        // (whose deadline is left out if bounded by iterations, so the search does not depend on timing)
+        std::string stoppedOn = (iterations > 0) ? "iterations" : "deadline";
+        Termination termination(criteria, (iterations > 0) ? INFINITY : deadline, &timer);
+        int exchanges = 0, accepted = 0;
+        for (int round = 0; iterations > 0 ? totalIterations < iterations : timer.check() < deadline; round++) {
+            int epoch = (iterations > 0) ? std::min(EXCHANGE_INTERVAL, iterations - totalIterations) : EXCHANGE_INTERVAL;
+            ThreadPool::shared().parallelFor(0, replicas, [&](int k) {
+                SearchState& state = states[k];
+                for (int j = 0; j < epoch; j++) {
+                    // Let the operator weigh its choice by the time left, which follows the iterations if given
+                    double elapsed = timer.check();
+                    double remaining = (iterations > 0) ? 1.0 - (double)state.iteration / iterations : (deadline - elapsed) / deadline;
+                    state.neighbourOperator->setDeadline(remaining, (iterations > 0) ? INFINITY : deadline - elapsed);
+                    temperingIteration(state, temperatures[k], elapsed);
+                }
+            });
+            totalIterations += epoch;
+            if (warmupAllocations == -1 && totalIterations >= SCRATCH_WARMUP_ITERATIONS) {
+                warmupAllocations = HeapCounter::allocations();
+                warmupIterations = totalIterations;
+            }
 
-            if (!solution.isFeasible()) {
-                continue;
+            // Exchange the solutions of neighbouring temperatures with the Metropolis criterion, alternating between even and odd pairs
+            for (int k = round % 2; k + 1 < replicas; k += 2) {
+                double exponent = (1.0 / temperatures[k] - 1.0 / temperatures[k+1]) * (states[k].incumbent.getCost() - states[k+1].incumbent.getCost());
+                exchanges++;
+                if (exponent >= 0 || random(rng) < std::exp(exponent)) {
+                    std::swap(states[k].incumbent, states[k+1].incumbent);
+                    accepted++;
+                }
             }
 
-            double d = dMultiplier * std::max(std::pow((deadline - timer.check()) / deadline, 2.0), 0.01) * bestSolution.getCost();
-            if (solution.getCost() < bestSolution.getCost() + d) {
-                incumbent = solution;
-                if (incumbent.getCost() < bestSolution.getCost()) {
-                    bestSolution = incumbent;
-                    iterfound = j;
-                    timefound = timer.check();
-                    lastBestFound = j;
-                    if (printEscapes) {
-                        Debugger::printToTerminal("Found new optimal at iteration: " + std::to_string(j) +". Cost: " + std::to_string(incumbent.getCost()) + "\n");
-                    }
+            // Check the termination criteria on the best replica, and when any replica last found a new best
+            int bestCost = INT_MAX, lastImprovement = 0;
+            for (int k = 0; k < replicas; k++) {
+                bestCost = std::min(bestCost, states[k].bestSolution.getCost());
+                lastImprovement = std::max(lastImprovement, states[k].iterfound);
+            }
+            if (termination.done(totalIterations, bestCost, lastImprovement)) {
+                stoppedOn = termination.reason();
+                break;
+            }
+
+            // Report the best replica to the budget controller, stopping once converged
+            if (budget != nullptr) {
+                if (!budget->report(slot, bestCost, timer.check())) {
+                    stoppedOn = "convergence";
+                    break;
                 }
             }
         }
+        if (budget != nullptr) {
+            budget->finish(slot, timer.check());
+        }
+        Debugger::printToTerminal("Accepted " + std::to_string(accepted) + " of " + std::to_string(exchanges) + " replica exchanges\n");
 
         // Capture current time
         timer.capture();
 
+        // The best replica (lowest index on ties) gives the result of the experiment
+        int bestReplica = 0;
+        for (int k = 1; k < replicas; k++) {
+            if (states[k].bestSolution.getCost() < states[bestReplica].bestSolution.getCost()) {
+                bestReplica = k;
+            }
+        }
+        Solution& bestSolution = states[bestReplica].bestSolution;
+
         // At the end of the experiment, count the current best cost towards the average cost
         averageObjective += (double)bestSolution.getCost() / experiments;
         // and check if it is better than the current best overall solution
@@ -527,11 +817,22 @@ AlgorithmInformation InstanceRunner::finalAdaptiveMetaheuristic(Operator* neighb
             bestSolutionOverall = bestSolution;
         }
 
+        // Sum up the insertion caches of all replicas, which exchanged solutions share with their origin
+        std::unordered_set<InsertionCache*> insertionCaches;
+        long long insertionCacheHits = 0, insertionCacheMisses = 0;
+        for (SearchState& state : states) {
+            if (insertionCaches.insert(state.incumbent.insertionCache.get()).second) {
+                insertionCacheHits += state.incumbent.insertionCache->hits();
+                insertionCacheMisses += state.incumbent.insertionCache->misses();
+            }
+        }
+
         // Store episode information
         int greedyCost = bestSolution.getCost();
         bestSolution.invalidateCache();
         int actualCost = bestSolution.getCost();
-        episodes.push_back({bestSolution, greedyCost, actualCost, iterfound, timefound, totalIterations});
+        double heapAllocations = (warmupAllocations == -1) ? -1 : (double)(HeapCounter::allocations() - warmupAllocations) / std::max(1, (totalIterations - warmupIterations) * replicas);
+        episodes.push_back({bestSolution, greedyCost, actualCost, states[bestReplica].iterfound, states[bestReplica].timefound, totalIterations * replicas, heapAllocations, insertionCacheHits, insertionCacheMisses, stoppedOn});
     }
 
     // Calculate the improvement from the initial solution
@@ -541,6 +842,111 @@ AlgorithmInformation InstanceRunner::finalAdaptiveMetaheuristic(Operator* neighb
     double averageTime = timer.retrieve();
 
     // Store and return algorithm information
-    AlgorithmInformation information = {instance, algorithm, averageObjective, bestSolutionOverall, improvement, averageTime, episodes};
+    AlgorithmInformation information = {instance, algorithm, averageObjective, bestSolutionOverall, improvement, averageTime, episodes, problem.routeCache->hitRate()};
     return information;
-}
\ No newline at end of file
+}
+
+void InstanceRunner::adaptiveIteration(SearchState& state, double remaining, double elapsed, double dMultiplier, bool printEscapes) {
+    int j = state.iteration++;
+    Solution& bestSolution = state.bestSolution;
+    Solution& incumbent = state.incumbent;
+
+    // Declare uniform [0, 1) distribution
+    std::uniform_real_distribution<double> random(0, 1);
+
+    // If long since successful modification of incumbant, run escape algorithm
+    if (j - state.lastBestFound >= ESCAPE_ITERATIONS) {
+        if (printEscapes) {
+            Debugger::printToTerminal("Applying escape at iteration: " + std::to_string(j) + "\n");
+        }
+
+        // Copy incumbant to not make changes to best solution
+        if (random(state.rng) < 2.0 / incumbent.problem->noCalls) {
+            incumbent = bestSolution.copy();
+        } else {
+            incumbent = incumbent.copy();
+        }
+
+        // Then perform many small steps with most diversifying operator
+        for (int k = 0; k < 25; k++) {
+            int lowerbound = std::max(1, (int)std::floor(incumbent.problem->noCalls / 50.0));
+            int upperbound = std::max(2, (int)std::ceil(incumbent.problem->noCalls / 15.0));
+            int callsToRemove = std::uniform_int_distribution<int>(lowerbound, upperbound)(state.rng);
+
+            // Random removal, releasing its scratch memory after every step
+            ArenaScope scope;
+            ScratchVector<int> removedCalls = removeRandom(callsToRemove, &incumbent, state.rng);
+
+            // Greedy insertion
+            std::sort(removedCalls.begin(), removedCalls.end());
+            // Tiny chance to insert random
+            insertGreedy(removedCalls, &incumbent);
+
+            if (incumbent.getCost() < bestSolution.getCost()) {
+                bestSolution = incumbent.copy();
+                state.iterfound = j;
+                state.timefound = elapsed;
+                if (printEscapes) {
+                    Debugger::printToTerminal("Found new optimal during escape! Cost: " + std::to_string(incumbent.getCost()) + "\n");
+                }
+            }
+        }
+        
+        state.lastBestFound = j;
+    }
+
+    // Generate a new neighbour solution, the best of a batch if more than one
+    Solution solution = state.neighbourOperator->applyBatch(&incumbent, j, state.batchSize, state.rng);
+
+    if (!solution.isFeasible()) {
+        return;
+    }
+
+    double d = dMultiplier * std::max(std::pow(remaining, 2.0), 0.01) * bestSolution.getCost();
+    if (solution.getCost() < bestSolution.getCost() + d) {
+        incumbent = solution;
+        if (incumbent.getCost() < bestSolution.getCost()) {
+            // Intensify around the new best solution by descending to a local optimum and optimally re-sequencing its small routes
+            LocalOptimizer(&incumbent).run();
+            resequenceRoutes(&incumbent);
+            bestSolution = incumbent;
+            state.iterfound = j;
+            state.timefound = elapsed;
+            state.lastBestFound = j;
+            if (printEscapes) {
+                Debugger::printToTerminal("Found new optimal at iteration: " + std::to_string(j) +". Cost: " + std::to_string(incumbent.getCost()) + "\n");
+            }
+        }
+    }
+}
+
+void InstanceRunner::temperingIteration(SearchState& state, double temperature, double elapsed) {
+    int j = state.iteration++;
+    Solution& bestSolution = state.bestSolution;
+    Solution& incumbent = state.incumbent;
+
+    // Declare uniform [0, 1) distribution
+    std::uniform_real_distribution<double> random(0, 1);
+
+    // Generate a new neighbour solution
+    Solution solution = state.neighbourOperator->apply(&incumbent, j, state.rng);
+
+    if (!solution.isFeasible()) {
+        return;
+    }
+
+    // Accept it by the Metropolis criterion at the temperature of the replica
+    double deltaE = solution.getCost() - incumbent.getCost();
+    if (deltaE < 0 || random(state.rng) < std::exp(-deltaE / temperature)) {
+        incumbent = solution;
+        if (incumbent.getCost() < bestSolution.getCost()) {
+            // Intensify around the new best solution by descending to a local optimum and optimally re-sequencing its small routes
+            LocalOptimizer(&incumbent).run();
+            resequenceRoutes(&incumbent);
+            bestSolution = incumbent;
+            state.iterfound = j;
+            state.timefound = elapsed;
+            state.lastBestFound = j;
+        }
+    }
+}
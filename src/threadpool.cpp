@@ -0,0 +1,180 @@
+#include "threadpool.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Remember which pool (and which worker of it) the current thread belongs to
+thread_local ThreadPool* currentPool = nullptr;
+thread_local int currentWorker = -1;
+
+ThreadPool::ThreadPool(int threads, bool pinned) : pinned(pinned) {
+    for (int i = 0; i < threads; i++) {
+        this->workers.push_back(std::make_unique<Worker>());
+    }
+    for (int i = 0; i < threads; i++) {
+        this->threads.emplace_back(&ThreadPool::work, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    // Tell every worker to stop once the queues are drained
+    {
+        std::lock_guard<std::mutex> lock(this->sleepMutex);
+        this->stopping = true;
+    }
+    this->wakeup.notify_all();
+
+    for (std::thread& thread : this->threads) {
+        thread.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    // The caller of parallelFor also works, so leave one core for it
+    static ThreadPool pool(std::max(0, (int)std::thread::hardware_concurrency() - 1), true);
+    return pool;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    // Without workers, simply run the task right away
+    if (this->workers.empty()) {
+        task();
+        return;
+    }
+
+    // Workers push onto their own queue, everyone else spreads tasks round-robin
+    int index = (currentPool == this) ? currentWorker : this->nextWorker++ % (int)this->workers.size();
+    {
+        std::lock_guard<std::mutex> lock(this->workers[index]->mutex);
+        this->workers[index]->tasks.push_back(std::move(task));
+    }
+
+    // Wake up a sleeping worker
+    {
+        std::lock_guard<std::mutex> lock(this->sleepMutex);
+        this->pending++;
+    }
+    this->wakeup.notify_one();
+}
+
+void ThreadPool::parallelFor(int begin, int end, std::function<void(int)> task) {
+    // Run small loops (or loops on a pool without workers) inline
+    if (end - begin <= 1 || this->workers.empty()) {
+        for (int i = begin; i < end; i++) {
+            task(i);
+        }
+        return;
+    }
+
+    // Queue a helper for every index but one, each claiming indices of this loop only,
+    // and sharing the loop with them as it may outlive this call
+    std::shared_ptr<Group> group = std::make_shared<Group>();
+    group->task = &task;
+    group->next = begin;
+    group->remaining = end - begin;
+    group->allocations = 0;
+    group->end = end;
+    for (int i = begin + 1; i < end; i++) {
+        this->submit([group]() {
+            ThreadPool::runGroup(*group, true);
+        });
+    }
+
+    // Claim indices alongside the helpers
+    ThreadPool::runGroup(*group, false);
+
+    // And sleep until those claimed by others are finished, taking over the heap allocations they made
+    std::unique_lock<std::mutex> lock(group->mutex);
+    group->finished.wait(lock, [&group]() {
+        return group->remaining == 0;
+    });
+    HeapCounter::credit(group->allocations);
+}
+
+void ThreadPool::runGroup(Group& group, bool helper) {
+    while (true) {
+        // Helpers running after every index was claimed return right away, without touching the task
+        int i = group.next++;
+        if (i >= group.end) {
+            return;
+        }
+        long long allocations = HeapCounter::allocations();
+        (*group.task)(i);
+        if (helper) {
+            group.allocations += HeapCounter::allocations() - allocations;
+        }
+
+        // Wake up the caller after the last index, holding the lock so it cannot miss it
+        if (--group.remaining == 0) {
+            std::lock_guard<std::mutex> lock(group.mutex);
+            group.finished.notify_all();
+        }
+    }
+}
+
+int ThreadPool::size() {
+    return this->workers.size();
+}
+
+bool ThreadPool::runPending(int preferred) {
+    std::function<void()> task;
+
+    // First look at the back of the preferred queue, then steal from the front of the others
+    for (int offset = 0; offset < this->workers.size() && !task; offset++) {
+        Worker& worker = *this->workers[(preferred + offset) % this->workers.size()];
+
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.tasks.empty()) {
+            continue;
+        }
+        if (offset == 0) {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+        } else {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+        }
+    }
+
+    if (!task) {
+        return false;
+    }
+
+    this->pending--;
+    task();
+    return true;
+}
+
+void ThreadPool::pin(int core) {
+#ifdef __linux__
+    cpu_set_t cores;
+    CPU_ZERO(&cores);
+    CPU_SET(core, &cores);
+    pthread_setaffinity_np(pthread_self(), sizeof(cores), &cores);
+#endif
+}
+
+void ThreadPool::work(int index) {
+    currentPool = this;
+    currentWorker = index;
+    if (this->pinned) {
+        ThreadPool::pin((index + 1) % std::max(1, (int)std::thread::hardware_concurrency()));
+    }
+
+    while (true) {
+        if (this->runPending(index)) {
+            continue;
+        }
+
+        // Sleep until new tasks arrive, or the pool is stopped
+        std::unique_lock<std::mutex> lock(this->sleepMutex);
+        this->wakeup.wait(lock, [this]() {
+            return this->pending > 0 || this->stopping;
+        });
+        if (this->stopping && this->pending == 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,90 @@
+#include <vector>
+#include <algorithm>
+
+#include "parser.h"
+#include "heuristics.h"
+#include "localsearch.h"
+
+// Perturbed solutions to descend from per instance, and the share of calls moved to perturb them
+const int LOCALSEARCH_TEST_SOLUTIONS = 10;
+const double LOCALSEARCH_TEST_PERTURBATION = 0.2;
+
+/**
+ * @brief Check the local search on perturbed solutions of the shipped instances.
+ * Starting from a greedy solution with random calls moved to random feasible positions, the descent has to keep the solution feasible,
+ * keep its cached cost equal to the one recomputed from scratch, and never end above the cost it started from.
+ */
+int main(int argc, char const *argv[])
+{
+    std::vector<std::string> instances = {
+        "Call_7_Vehicle_3",
+        "Call_18_Vehicle_5",
+        "Call_35_Vehicle_7",
+        "Call_80_Vehicle_20",
+        "Call_130_Vehicle_40",
+        "Call_300_Vehicle_90"
+    };
+
+    Xoshiro256 rng(42);
+    int failures = 0;
+    for (std::string& instance : instances) {
+        Problem problem = Parser::parseProblem("data/" + instance + ".txt");
+
+        // Start from every call inserted greedily
+        Solution greedy = Solution::initialSolution(&problem);
+        {
+            ArenaScope scope;
+            ScratchVector<int> calls = removeRandom(problem.noCalls, &greedy, rng);
+            std::sort(calls.begin(), calls.end());
+            insertGreedy(calls, &greedy);
+        }
+
+        int improvedSolutions = 0;
+        for (int test = 0; test < LOCALSEARCH_TEST_SOLUTIONS; test++) {
+            // Perturb it by moving random calls to random feasible positions
+            Solution solution = greedy.copy();
+            {
+                ArenaScope scope;
+                ScratchVector<int> removedCalls = removeRandom(std::max(1, (int) (problem.noCalls * LOCALSEARCH_TEST_PERTURBATION)), &solution, rng);
+                std::sort(removedCalls.begin(), removedCalls.end());
+                insertRandom(removedCalls, &solution, rng);
+            }
+            if (!solution.isFeasible()) {
+                std::cerr << "ERROR: " << instance << " perturbed solution " << test << " is infeasible" << std::endl;
+                failures++;
+                continue;
+            }
+            int startCost = solution.getCost();
+
+            int moves = LocalOptimizer(&solution).run();
+            int cachedCost = solution.getCost();
+            solution.invalidateCache();
+            bool feasible = solution.isFeasible();
+            int cost = solution.getCost();
+            if (!feasible) {
+                std::cerr << "ERROR: " << instance << " solution " << test << " is infeasible after " << moves << " moves" << std::endl;
+                failures++;
+            }
+            if (cost != cachedCost) {
+                std::cerr << "ERROR: " << instance << " solution " << test << " has cached cost " << cachedCost << " after " << moves << " moves, but costs " << cost << std::endl;
+                failures++;
+            }
+            if (cost > startCost || (moves > 0 && cost == startCost)) {
+                std::cerr << "ERROR: " << instance << " solution " << test << " went from cost " << startCost << " to " << cost << " in " << moves << " moves" << std::endl;
+                failures++;
+            }
+            improvedSolutions += (cost < startCost);
+        }
+
+        // The perturbations have to leave something to improve for the descent to be checked at all
+        if (improvedSolutions == 0) {
+            std::cerr << "ERROR: " << instance << " has no perturbed solution the local search improves" << std::endl;
+            failures++;
+        }
+    }
+
+    if (failures == 0) {
+        std::cout << "Local search keeps perturbed solutions feasible and improves them on all instances" << std::endl;
+    }
+    return (failures == 0) ? 0 : 1;
+}
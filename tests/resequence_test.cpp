@@ -0,0 +1,152 @@
+#include <vector>
+#include <climits>
+#include <algorithm>
+
+#include "parser.h"
+#include "resequence.h"
+
+// Random call sets to sequence per instance and number of calls
+const int RESEQUENCE_TEST_ROUTES = 20;
+
+/**
+ * @brief Find the cheapest feasible order of a set of calls in a vehicle by trying every order of their stops,
+ * as simulated by the solution itself.
+ *
+ * @param solution Solution in which the calls are in no route
+ * @param vehicleIndex Vehicle to drive the route
+ * @param calls Calls to sequence, each once
+ * @return Cost of the best route, INT_MAX if there is no feasible order
+ */
+int bruteForceSequence(Solution& solution, int vehicleIndex, std::vector<int>& calls) {
+    // Every distinct permutation of both stops of each call, where the first occurence of a call is its pickup
+    std::vector<int> route;
+    for (int callIndex : calls) {
+        route.push_back(callIndex);
+        route.push_back(callIndex);
+    }
+    std::sort(route.begin(), route.end());
+
+    int bestCost = INT_MAX;
+    do {
+        solution.replaceRoute(vehicleIndex, route);
+        solution.invalidateCache();
+        if (solution.isFeasible()) {
+            solution.getCost();
+            bestCost = std::min(bestCost, solution.costs[vehicleIndex-1]);
+        }
+    } while (std::next_permutation(route.begin(), route.end()));
+    return bestCost;
+}
+
+/**
+ * @brief Check the exact re-sequencing of small routes of the shipped instances against brute force.
+ * The dynamic program has to find the cost of the best of all orders, and a route which is feasible and costs that,
+ * and re-sequencing the route of a solution may never make it more expensive.
+ */
+int main(int argc, char const *argv[])
+{
+    std::vector<std::string> instances = {
+        "Call_7_Vehicle_3",
+        "Call_18_Vehicle_5",
+        "Call_35_Vehicle_7",
+        "Call_80_Vehicle_20",
+        "Call_130_Vehicle_40",
+        "Call_300_Vehicle_90"
+    };
+
+    Xoshiro256 rng(42);
+    int failures = 0;
+    for (std::string& instance : instances) {
+        Problem problem = Parser::parseProblem("data/" + instance + ".txt");
+
+        int feasibleSets = 0;
+        for (int noCalls = 2; noCalls <= 4; noCalls++) {
+            for (int test = 0; test < RESEQUENCE_TEST_ROUTES; test++) {
+                // Pick a random vehicle and some of the calls it may take
+                int vehicleIndex = std::uniform_int_distribution<int>(1, problem.noVehicles)(rng);
+                Vehicle& vehicle = problem.vehicles[vehicleIndex-1];
+                std::vector<int> calls = vehicle.possibleCalls;
+                if (calls.size() < noCalls) {
+                    continue;
+                }
+                std::shuffle(calls.begin(), calls.end(), rng);
+                calls.resize(noCalls);
+
+                // Take the calls out of the outsourced ones, so they only ever are in the vehicle
+                Solution solution = Solution::initialSolution(&problem);
+                for (int callIndex : calls) {
+                    solution.remove(callIndex);
+                }
+                int expected = bruteForceSequence(solution, vehicleIndex, calls);
+
+                std::vector<int> route;
+                int cost;
+                {
+                    ArenaScope scope;
+                    cost = sequenceCalls(&problem, vehicle, calls, route);
+                }
+                if (cost != expected) {
+                    std::cerr << "ERROR: " << instance << " vehicle " << vehicleIndex << " sequences " << noCalls << " calls at cost " << cost << ", brute force finds " << expected << std::endl;
+                    failures++;
+                    continue;
+                }
+                if (cost == INT_MAX) {
+                    continue;
+                }
+                feasibleSets++;
+
+                // The route found has to visit both stops of every call, and be feasible at the cost found
+                std::vector<int> sortedRoute(route), sortedStops;
+                for (int callIndex : calls) {
+                    sortedStops.push_back(callIndex);
+                    sortedStops.push_back(callIndex);
+                }
+                std::sort(sortedRoute.begin(), sortedRoute.end());
+                std::sort(sortedStops.begin(), sortedStops.end());
+                if (sortedRoute != sortedStops) {
+                    std::cerr << "ERROR: " << instance << " vehicle " << vehicleIndex << " sequences " << noCalls << " calls into a route not visiting both stops of each" << std::endl;
+                    failures++;
+                    continue;
+                }
+                solution.replaceRoute(vehicleIndex, route);
+                solution.invalidateCache();
+                bool feasible = solution.isFeasible();
+                solution.getCost();
+                if (!feasible || solution.costs[vehicleIndex-1] != cost) {
+                    std::cerr << "ERROR: " << instance << " vehicle " << vehicleIndex << " sequences " << noCalls << " calls into a route which is " << (feasible ? "feasible" : "infeasible") << " at cost " << solution.costs[vehicleIndex-1] << ", expected feasible at " << cost << std::endl;
+                    failures++;
+                }
+            }
+        }
+
+        // Re-sequencing random routes of random solutions never makes them more expensive, and keeps feasible routes feasible
+        for (int test = 0; test < RESEQUENCE_TEST_ROUTES; test++) {
+            Solution solution = Solution::randomSolution(&problem, rng);
+            for (int vehicleIndex = 1; vehicleIndex <= problem.noVehicles; vehicleIndex++) {
+                solution.invalidateCache();
+                bool feasibleBefore = solution.isFeasible();
+                int costBefore = solution.getCost();
+
+                bool improved = resequenceRoute(vehicleIndex, &solution);
+                solution.invalidateCache();
+                bool feasibleAfter = solution.isFeasible();
+                int costAfter = solution.getCost();
+                if (costAfter > costBefore || (improved && costAfter == costBefore) || (feasibleBefore && !feasibleAfter)) {
+                    std::cerr << "ERROR: " << instance << " re-sequencing vehicle " << vehicleIndex << " changed the cost from " << costBefore << " to " << costAfter << (feasibleBefore && !feasibleAfter ? ", and made it infeasible" : "") << std::endl;
+                    failures++;
+                }
+            }
+        }
+
+        // Feasible call sets have to be covered for the routes to be checked at all
+        if (feasibleSets == 0) {
+            std::cerr << "ERROR: " << instance << " has no feasible call set to sequence" << std::endl;
+            failures++;
+        }
+    }
+
+    if (failures == 0) {
+        std::cout << "Re-sequencing agrees with brute force on all instances" << std::endl;
+    }
+    return (failures == 0) ? 0 : 1;
+}
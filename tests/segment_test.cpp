@@ -0,0 +1,85 @@
+#include <map>
+#include <vector>
+#include <algorithm>
+
+#include "parser.h"
+#include "segment.h"
+
+// Random routes to check per instance, and most calls in one of them
+const int SEGMENT_TEST_ROUTES = 500;
+const int SEGMENT_TEST_MAX_CALLS = 5;
+
+/**
+ * @brief Check the route segments against the solution's own simulation of random routes of the shipped instances.
+ * The segment of the vehicle's start followed by the whole route has to be feasible exactly if the solution is,
+ * and cost what the solution computes for the route once its caches are invalidated.
+ */
+int main(int argc, char const *argv[])
+{
+    std::vector<std::string> instances = {
+        "Call_7_Vehicle_3",
+        "Call_18_Vehicle_5",
+        "Call_35_Vehicle_7",
+        "Call_80_Vehicle_20",
+        "Call_130_Vehicle_40",
+        "Call_300_Vehicle_90"
+    };
+
+    Xoshiro256 rng(42);
+    int failures = 0;
+    for (std::string& instance : instances) {
+        Problem problem = Parser::parseProblem("data/" + instance + ".txt");
+
+        int feasibleRoutes = 0;
+        for (int test = 0; test < SEGMENT_TEST_ROUTES; test++) {
+            // Pick a random vehicle and some of the calls it may take, both stops of them in a random order
+            int vehicleIndex = std::uniform_int_distribution<int>(1, problem.noVehicles)(rng);
+            std::vector<int> calls = problem.vehicles[vehicleIndex-1].possibleCalls;
+            if (calls.empty()) {
+                continue;
+            }
+            std::shuffle(calls.begin(), calls.end(), rng);
+            calls.resize(std::uniform_int_distribution<int>(1, std::min<int>(calls.size(), SEGMENT_TEST_MAX_CALLS))(rng));
+
+            std::vector<int> route;
+            for (int callIndex : calls) {
+                route.push_back(callIndex);
+                route.push_back(callIndex);
+            }
+            std::shuffle(route.begin(), route.end(), rng);
+
+            // Give the route to the vehicle, with every other call outsourced
+            Solution solution = Solution::initialSolution(&problem);
+            for (int callIndex : calls) {
+                solution.remove(callIndex);
+            }
+            solution.replaceRoute(vehicleIndex, route);
+            solution.invalidateCache();
+            bool feasible = solution.isFeasible();
+            solution.getCost();
+
+            RouteSegments segments(vehicleIndex, route, &solution);
+            Segment& segment = segments.prefix(segments.stops);
+            if (isSegmentFeasible(problem.vehicles[vehicleIndex-1], segment) != feasible) {
+                std::cerr << "ERROR: " << instance << " vehicle " << vehicleIndex << " route of " << calls.size() << " calls is " << (feasible ? "feasible" : "infeasible") << ", but its segment is not" << std::endl;
+                failures++;
+            }
+            if (segment.cost != solution.costs[vehicleIndex-1]) {
+                std::cerr << "ERROR: " << instance << " vehicle " << vehicleIndex << " route of " << calls.size() << " calls costs " << solution.costs[vehicleIndex-1] << ", but its segment " << segment.cost << std::endl;
+                failures++;
+            }
+            feasibleRoutes += feasible;
+        }
+
+        // Both outcomes have to be covered for the feasibility check to mean anything
+        if (feasibleRoutes == 0 || feasibleRoutes == SEGMENT_TEST_ROUTES) {
+            std::cerr << "ERROR: " << instance << " has " << feasibleRoutes << " feasible routes out of " << SEGMENT_TEST_ROUTES << ", expected both outcomes" << std::endl;
+            failures++;
+        }
+    }
+
+    if (failures == 0) {
+        std::cout << "Route segments agree with the solution on all instances" << std::endl;
+    }
+    return (failures == 0) ? 0 : 1;
+}
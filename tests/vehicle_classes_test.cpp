@@ -0,0 +1,56 @@
+#include <set>
+#include <map>
+
+#include "parser.h"
+
+/**
+ * @brief Check how the parser groups the vehicles of the shipped instances into equivalence classes.
+ * Call_130_Vehicle_40 and Call_300_Vehicle_90 have interchangeable vehicles, every vehicle of the other instances is a class of its own.
+ */
+int main(int argc, char const *argv[])
+{
+    std::map<std::string, int> expectedClasses = {
+        {"Call_7_Vehicle_3", 3},
+        {"Call_18_Vehicle_5", 5},
+        {"Call_35_Vehicle_7", 7},
+        {"Call_80_Vehicle_20", 20},
+        {"Call_130_Vehicle_40", 37},
+        {"Call_300_Vehicle_90", 82}
+    };
+
+    int failures = 0;
+    for (auto && [instance, expected] : expectedClasses) {
+        Problem problem = Parser::parseProblem("data/" + instance + ".txt");
+
+        // Count the classes, each named after its first vehicle
+        std::set<int> classes;
+        for (int vehicleIndex = 1; vehicleIndex <= problem.noVehicles; vehicleIndex++) {
+            int equivalenceClass = problem.vehicles[vehicleIndex-1].equivalenceClass;
+            if (equivalenceClass > vehicleIndex || problem.vehicles[equivalenceClass-1].equivalenceClass != equivalenceClass) {
+                std::cerr << "ERROR: " << instance << " vehicle " << vehicleIndex << " is in class " << equivalenceClass << ", which is not named after its first vehicle" << std::endl;
+                failures++;
+            }
+            classes.insert(equivalenceClass);
+        }
+        if (classes.size() != expected) {
+            std::cerr << "ERROR: " << instance << " has " << classes.size() << " vehicle classes, expected " << expected << std::endl;
+            failures++;
+        }
+    }
+
+    // Of Call_130_Vehicle_40, exactly vehicles 14, 32 and 35 share the class of an earlier vehicle
+    Problem problem = Parser::parseProblem("data/Call_130_Vehicle_40.txt");
+    std::map<int, int> expectedGroups = {{14, 3}, {32, 25}, {35, 22}};
+    for (int vehicleIndex = 1; vehicleIndex <= problem.noVehicles; vehicleIndex++) {
+        int expected = (expectedGroups.count(vehicleIndex) > 0) ? expectedGroups[vehicleIndex] : vehicleIndex;
+        if (problem.vehicles[vehicleIndex-1].equivalenceClass != expected) {
+            std::cerr << "ERROR: Call_130_Vehicle_40 vehicle " << vehicleIndex << " is in class " << problem.vehicles[vehicleIndex-1].equivalenceClass << ", expected " << expected << std::endl;
+            failures++;
+        }
+    }
+
+    if (failures == 0) {
+        std::cout << "Vehicle classes of all instances are as expected" << std::endl;
+    }
+    return (failures == 0) ? 0 : 1;
+}